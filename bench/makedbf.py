@@ -0,0 +1,203 @@
+#!/usr/bin/env python3
+
+"""Generate a synthetic Visual FoxPro table, with a memo file if it has
+memo fields, for benchmarking PgDBF"""
+
+import argparse
+import random
+import struct
+
+# The width and decimal count of each supported field type. 'C' fields get
+# a random width from CHARWIDTHS so that tables aren't all alike.
+FIELDSIZES = {
+    'B': (8, 3),
+    'D': (8, 0),
+    'F': (14, 4),
+    'I': (4, 0),
+    'L': (1, 0),
+    'M': (4, 0),
+    'N': (12, 2),
+    'T': (8, 0),
+    'Y': (8, 4),
+}
+CHARWIDTHS = (10, 20, 40, 80)
+
+WORDS = ('alpha', 'bravo', 'charlie', 'delta', 'echo', 'foxtrot', 'golf',
+         'hotel', 'india', 'juliet', 'kilo', 'lima', 'mike', 'november')
+ACCENTED = b'caf\xe9 cr\xe8me br\xfbl\xe9e'
+
+MEMOBLOCKSIZE = 64
+
+
+def parse_mix(mix):
+    """Turn "C:3,N:2,M:1" into [('C', 3), ('N', 2), ('M', 1)]"""
+    result = []
+    for part in mix.split(','):
+        fieldtype, _, count = part.partition(':')
+        fieldtype = fieldtype.strip().upper()
+        if fieldtype != 'C' and fieldtype not in FIELDSIZES:
+            raise ValueError('unsupported field type %r' % fieldtype)
+        result.append((fieldtype, int(count or 1)))
+    return result
+
+
+def memo_sizer(spec, rand):
+    """Return a function that picks memo lengths according to spec, which is
+    "fixed:N", "uniform:MIN:MAX", or "exp:MEAN\""""
+    kind, _, args = spec.partition(':')
+    values = [int(value) for value in args.split(':') if value]
+    if kind == 'fixed':
+        return lambda: values[0]
+    if kind == 'uniform':
+        return lambda: rand.randint(values[0], values[1])
+    if kind == 'exp':
+        return lambda: int(rand.expovariate(1.0 / values[0]))
+    raise ValueError('unknown memo size distribution %r' % spec)
+
+
+def make_fields(mix, rand):
+    """Return the (name, type, length, decimals) of each field"""
+    fields = []
+    for fieldtype, count in mix:
+        for _ in range(count):
+            name = '%s%d' % (fieldtype, len(fields) + 1)
+            if fieldtype == 'C':
+                length, decimals = rand.choice(CHARWIDTHS), 0
+            else:
+                length, decimals = FIELDSIZES[fieldtype]
+            fields.append((name, fieldtype, length, decimals))
+    return fields
+
+
+def make_text(rand, length):
+    """Return mostly-ASCII text of about the given length, with the
+    occasional character that COPY has to escape or a codepage has to
+    convert"""
+    words = []
+    size = 0
+    while size < length:
+        choice = rand.random()
+        if choice < 0.02:
+            word = ACCENTED
+        elif choice < 0.04:
+            word = rand.choice((b'tab\there', b'back\\slash', b'new\nline'))
+        else:
+            word = rand.choice(WORDS).encode()
+        words.append(word)
+        size += len(word) + 1
+    return b' '.join(words)[:length]
+
+
+def make_value(rand, fieldtype, length, decimals):
+    """Return the bytes of one field value"""
+    if fieldtype == 'C':
+        return make_text(rand, rand.randint(0, length)).ljust(length, b' ')
+    if fieldtype in 'NF':
+        if rand.random() < 0.05:
+            return b' ' * length
+        limit = 10 ** (length - decimals - 2) - 1
+        return ('%*.*f' % (length, decimals, rand.uniform(-limit, limit))).encode()
+    if fieldtype == 'D':
+        return ('%04d%02d%02d' % (rand.randint(1900, 2030), rand.randint(1, 12), rand.randint(1, 28))).encode()
+    if fieldtype == 'T':
+        return struct.pack('<ii', rand.randint(2415021, 2462502), rand.randint(0, 86399999))
+    if fieldtype == 'I':
+        return struct.pack('<i', rand.randint(-2 ** 31, 2 ** 31 - 1))
+    if fieldtype == 'B':
+        return struct.pack('<d', rand.uniform(-1e9, 1e9))
+    if fieldtype == 'Y':
+        return struct.pack('<q', rand.randint(-10 ** 12, 10 ** 12))
+    if fieldtype == 'L':
+        return rand.choice((b'T', b'F', b'?'))
+    raise ValueError(fieldtype)
+
+
+def generate(basename, rows, mix, memosize='exp:200', fragmentation=0.0, deleted=0.01, seed=1):
+    """Write basename.dbf, and basename.fpt if the table has memo fields.
+    fragmentation is the fraction of memos that are stored out of order."""
+    rand = random.Random(seed)
+    fields = make_fields(parse_mix(mix), rand)
+    recordlength = 1 + sum(field[2] for field in fields)
+    headerlength = 32 + 32 * len(fields) + 1 + 263
+    memofieldcount = sum(1 for field in fields if field[1] == 'M')
+    nextmemosize = memo_sizer(memosize, rand)
+
+    # The memo file is laid out after every record is generated, so each
+    # memo field temporarily holds the index of its memo in memos.
+    memos = []
+    records = []
+    for _ in range(rows):
+        values = [b'*' if rand.random() < deleted else b' ']
+        for name, fieldtype, length, decimals in fields:
+            if fieldtype == 'M':
+                if rand.random() < 0.1:
+                    values.append(None)
+                else:
+                    values.append(len(memos))
+                    memos.append(make_text(rand, nextmemosize()))
+            else:
+                values.append(make_value(rand, fieldtype, length, decimals))
+        records.append(values)
+
+    # Decide where each memo goes. A fragmented file stores a random subset
+    # of them in shuffled order, like a table whose memos have been edited
+    # many times.
+    order = list(range(len(memos)))
+    moved = rand.sample(order, int(len(order) * fragmentation))
+    shuffled = moved[:]
+    rand.shuffle(shuffled)
+    for source, destination in zip(moved, shuffled):
+        order[source] = destination
+    placement = sorted(range(len(memos)), key=lambda memo: order[memo])
+    blocks = [0] * len(memos)
+    nextblock = 512 // MEMOBLOCKSIZE
+    memodata = bytearray(512)
+    for memo in placement:
+        blocks[memo] = nextblock
+        body = struct.pack('>II', 1, len(memos[memo])) + memos[memo]
+        padding = -len(body) % MEMOBLOCKSIZE
+        memodata += body + b'\0' * padding
+        nextblock += (len(body) + padding) // MEMOBLOCKSIZE
+    memodata[0:4] = struct.pack('>I', nextblock)
+    memodata[6:8] = struct.pack('>H', MEMOBLOCKSIZE)
+
+    header = struct.pack('<BBBBIHH', 0x30, 124, 1, 1, rows, headerlength, recordlength)
+    header += b'\0' * 17 + b'\x03' + b'\0\0'
+    descriptors = b''
+    offset = 1
+    for name, fieldtype, length, decimals in fields:
+        descriptors += (name.encode().ljust(11, b'\0') + fieldtype.encode() + struct.pack('<I', offset) +
+                        bytes([length, decimals]) + b'\0' * 14)
+        offset += length
+
+    with open(basename + '.dbf', 'wb') as dbffile:
+        dbffile.write(header + descriptors + b'\r' + b'\0' * 263)
+        for values in records:
+            dbffile.write(b''.join(value if isinstance(value, bytes) else
+                                   struct.pack('<i', 0 if value is None else blocks[value])
+                                   for value in values))
+        dbffile.write(b'\x1a')
+    if memofieldcount:
+        with open(basename + '.fpt', 'wb') as memofile:
+            memofile.write(memodata)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('basename', help='Write basename.dbf and basename.fpt')
+    parser.add_argument('--rows', type=int, default=100000)
+    parser.add_argument('--mix', default='C:4,N:2,D:1,T:1,I:1,B:1,Y:1,L:1,M:1',
+                        help='Field types and how many of each, like "C:4,N:2,M:1"')
+    parser.add_argument('--memo-size', default='exp:200',
+                        help='Memo lengths: "fixed:N", "uniform:MIN:MAX", or "exp:MEAN"')
+    parser.add_argument('--fragmentation', type=float, default=0.0,
+                        help='The fraction of memos stored out of order, from 0 to 1')
+    parser.add_argument('--deleted', type=float, default=0.01,
+                        help='The fraction of records marked as deleted')
+    parser.add_argument('--seed', type=int, default=1)
+    args = parser.parse_args()
+    generate(args.basename, args.rows, args.mix, args.memo_size, args.fragmentation, args.deleted, args.seed)
+
+
+if __name__ == '__main__':
+    main()
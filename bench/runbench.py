@@ -0,0 +1,111 @@
+#!/usr/bin/env python3
+
+"""Run PgDBF against a set of synthetic tables and report its throughput as
+one JSON object per scenario"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+from hashlib import md5
+from os.path import abspath, dirname, exists, getsize, join
+
+BENCHDIR = dirname(abspath(__file__))
+
+
+def table_for(scenario, datadir, scale):
+    """Generate the scenario's table unless an identical one already exists,
+    and return its base filename"""
+    params = {
+        'rows': max(1, int(scenario['rows'] * scale)),
+        'mix': scenario['mix'],
+        'memosize': scenario.get('memo_size', 'exp:200'),
+        'fragmentation': scenario.get('fragmentation', 0.0),
+        'deleted': scenario.get('deleted', 0.01),
+        'seed': scenario.get('seed', 1),
+    }
+    key = md5(json.dumps(params, sort_keys=True).encode()).hexdigest()[:12]
+    basename = join(datadir, 'bench_%s' % key)
+    if not exists(basename + '.dbf'):
+        # Generating a big table in this process would make it large, and
+        # every run forked from it afterward would start out that big
+        print('Generating %s (%d rows)' % (scenario['name'], params['rows']), file=sys.stderr)
+        subprocess.run([sys.executable, join(BENCHDIR, 'makedbf.py'), basename,
+                        '--rows', str(params['rows']), '--mix', params['mix'],
+                        '--memo-size', params['memosize'], '--fragmentation', str(params['fragmentation']),
+                        '--deleted', str(params['deleted']), '--seed', str(params['seed'])], check=True)
+    return basename, params['rows']
+
+
+def run_once(command):
+    """Run pgdbf once with its output thrown away, and return the elapsed
+    seconds and its peak RSS in KB. It's run by runonce.py in a fresh,
+    small interpreter, so that its peak RSS isn't this process's size."""
+    result = subprocess.run([sys.executable, '-S', join(BENCHDIR, 'runonce.py')] + command,
+                            stdout=subprocess.PIPE, check=True)
+    run = json.loads(result.stdout)
+    status = run['status']
+    if not os.WIFEXITED(status) or os.WEXITSTATUS(status) != 0:
+        raise RuntimeError('%s failed with status %d' % (' '.join(command), status))
+    return run['seconds'], run['maxrss_kb']
+
+
+def run_scenario(pgdbf, scenario, datadir, scale, repeat):
+    """Benchmark one scenario and return its results. The fastest of the
+    runs is reported, since slower runs mostly measure other activity on the
+    machine."""
+    basename, rows = table_for(scenario, datadir, scale)
+    dbfsize = getsize(basename + '.dbf')
+    memosize = getsize(basename + '.fpt') if exists(basename + '.fpt') else 0
+    command = [pgdbf] + scenario.get('args', [])
+    if memosize:
+        command += ['-m', basename + '.fpt']
+    command.append(basename + '.dbf')
+
+    runs = [run_once(command) for _ in range(repeat)]
+    seconds = min(run[0] for run in runs)
+    return {
+        'scenario': scenario['name'],
+        'rows': rows,
+        'input_bytes': dbfsize + memosize,
+        'seconds': round(seconds, 4),
+        'rows_per_sec': round(rows / seconds),
+        'mb_per_sec': round((dbfsize + memosize) / seconds / 1e6, 2),
+        'peak_rss_kb': max(run[1] for run in runs),
+        'args': scenario.get('args', []),
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('--pgdbf', '-p', default='pgdbf', help='Path to the pgdbf executable')
+    parser.add_argument('--scenarios', default=join(BENCHDIR, 'scenarios.json'),
+                        help='The JSON file describing the scenarios')
+    parser.add_argument('--data-dir', default=join(BENCHDIR, 'data'),
+                        help='Where generated tables are kept between runs')
+    parser.add_argument('--scale', type=float, default=1.0,
+                        help='Multiply every scenario\'s row count by this')
+    parser.add_argument('--repeat', type=int, default=3,
+                        help='Run each scenario this many times and report the fastest')
+    parser.add_argument('scenario', nargs='*', help='Only run the scenarios with these names')
+    args = parser.parse_args()
+
+    with open(args.scenarios) as scenariofile:
+        scenarios = json.load(scenariofile)
+    if args.scenario:
+        scenarios = [scenario for scenario in scenarios if scenario['name'] in args.scenario]
+    os.makedirs(args.data_dir, exist_ok=True)
+    pgdbf = args.pgdbf
+    if os.sep in pgdbf:
+        pgdbf = abspath(pgdbf)
+    else:
+        pgdbf = next((join(path, pgdbf) for path in os.environ.get('PATH', '').split(os.pathsep)
+                      if os.access(join(path, pgdbf), os.X_OK)), pgdbf)
+
+    for scenario in scenarios:
+        print(json.dumps(run_scenario(pgdbf, scenario, args.data_dir, args.scale, args.repeat)), flush=True)
+
+
+if __name__ == '__main__':
+    main()
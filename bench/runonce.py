@@ -0,0 +1,33 @@
+#!/usr/bin/env python3
+
+"""Run one command with its output thrown away, and print its elapsed
+seconds and peak RSS in KB as JSON.
+
+On Linux, a child's peak RSS starts at its parent's size when it was forked,
+even after exec. runbench.py starts this script fresh so that the command is
+forked from a small process instead of from the benchmark driver."""
+
+import json
+import os
+import sys
+import time
+
+
+def main():
+    command = sys.argv[1:]
+    devnull = os.open(os.devnull, os.O_WRONLY)
+    start = time.perf_counter()
+    pid = os.fork()
+    if not pid:
+        os.dup2(devnull, 1)
+        try:
+            os.execv(command[0], command)
+        finally:
+            os._exit(127)
+    _, status, usage = os.wait4(pid, 0)
+    elapsed = time.perf_counter() - start
+    print(json.dumps({'seconds': elapsed, 'status': status, 'maxrss_kb': usage.ru_maxrss}))
+
+
+if __name__ == '__main__':
+    main()
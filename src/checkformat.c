@@ -0,0 +1,231 @@
+/* PgDBF - Quickly convert DBF files to PostgreSQL                       */
+/* Copyright (C) 2008-2012  Kirk Strauser <kirk@strauser.com>            */
+/*                                                                       */
+/* This program is free software: you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation, either version 3 of the License, or     */
+/* (at your option) any later version.                                   */
+/*                                                                       */
+/* This program is distributed in the hope that it will be useful,       */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of        */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         */
+/* GNU General Public License for more details.                          */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+/* Compare PgDBF's hand-written number formatters against printf() on lots
+ * of random values. Run by "make check". */
+
+#include <config.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pgdbf.h"
+
+/* How many random values to try with each formatter */
+#define ITERATIONS 2000000
+
+/* The byte scanning kernels are tried on every buffer length up to this,
+ * starting at every offset up to SCANMISALIGNMENTS into an aligned array */
+#define SCANMAXLENGTH 100
+#define SCANMISALIGNMENTS 33
+#define SCANFILLS 20
+
+static uint64_t randomstate = 0x9E3779B97F4A7C15ULL;
+
+static uint64_t random64(void) {
+    /* xorshift64*, which is plenty random for picking test values */
+    randomstate ^= randomstate >> 12;
+    randomstate ^= randomstate << 25;
+    randomstate ^= randomstate >> 27;
+    return randomstate * 0x2545F4914F6CDD1DULL;
+}
+
+static double randomdouble(void) {
+    /* Return a double from one of several distributions, so that every
+     * path through outbuffixed() gets exercised */
+    union {
+        uint64_t asbits;
+        double   asdouble;
+    } bitstodouble;
+
+    switch(random64() % 6) {
+    case 0:
+        /* Any bit pattern at all, including NaNs and infinities */
+        bitstodouble.asbits = random64();
+        return bitstodouble.asdouble;
+    case 1:
+        /* Money-like amounts with a few decimals */
+        return (double) ((int64_t) (random64() % 2000000000) - 1000000000) / POWERSOF10[random64() % 5];
+    case 2:
+        /* Exact halves, quarters, and eighths, which are rounding ties */
+        return (double) ((int64_t) (random64() % 2000000) - 1000000) / (1 << (random64() % 4));
+    case 3:
+        /* Tiny values that round to zero or nearly */
+        return ((double) random64() / 18446744073709551616.0 - 0.5) * 1e-15;
+    case 4:
+        /* Huge values near the limits of the fast path */
+        return ((double) random64() / 18446744073709551616.0 - 0.5) * 3.7e19;
+    default:
+        /* Ordinary floats across a wide range of magnitudes */
+        return ((double) random64() / 18446744073709551616.0 - 0.5) * POWERSOF10[random64() % 20];
+    }
+}
+
+static void fillscanbuffer(char *buf, const int length) {
+    /* Fill buf with ordinary letters, then scatter bytes that the kernels
+     * look for through it, and sometimes pad its end with spaces and NULs */
+    static const char SPECIALS[] = {' ', '\0', '\\', '\t', '\n', '\r'};
+    int specials;
+    int padding;
+    int j;
+
+    for(j = 0; j < length; j++) {
+        buf[j] = 'a' + random64() % 26;
+    }
+    if(length == 0) {
+        return;
+    }
+    for(specials = random64() % 4; specials > 0; specials--) {
+        j = random64() % length;
+        if(random64() % 7 == 0) {
+            buf[j] = (char) (0x80 | random64());
+        } else {
+            buf[j] = SPECIALS[random64() % sizeof(SPECIALS)];
+        }
+    }
+    for(padding = random64() % (length + 1); padding > 0; padding--) {
+        buf[length - padding] = random64() % 2 ? ' ' : '\0';
+    }
+}
+
+static int checkscan(const char *kernel, const char *buf, const int length, const size_t expected, const size_t actual) {
+    /* Compare a selected kernel's answer with the scalar one. Returns 1 if
+     * they differ. */
+    int j;
+
+    if(expected == actual) {
+        return 0;
+    }
+    fprintf(stderr, "%s() of %d bytes at %p: expected %lu, got %lu:", kernel, length, (const void *) buf,
+            (unsigned long) expected, (unsigned long) actual);
+    for(j = 0; j < length; j++) {
+        fprintf(stderr, " %02x", (uint8_t) buf[j]);
+    }
+    fprintf(stderr, "\n");
+    return 1;
+}
+
+static int checkoutput(OUTBUF *outbuf, const char *expected, const char *what) {
+    /* Compare the buffer's contents with the expected string, then empty
+     * it. Returns 1 if they differ. */
+    int differ = outbuf->length != strlen(expected) || memcmp(outbuf->data, expected, outbuf->length);
+
+    if(differ) {
+        fprintf(stderr, "%s: expected \"%s\", got \"%.*s\"\n", what, expected, (int) outbuf->length, outbuf->data);
+    }
+    outbuf->length = 0;
+    return differ;
+}
+
+int main(void) {
+    OUTBUF   outbuf;
+    char     expected[400];
+    char     what[100];
+    char     bytes[200];
+    char     hex[400];
+    char     scanbuffer[SCANMAXLENGTH + SCANMISALIGNMENTS] __attribute__((aligned(32)));
+    char    *scanned;
+    int      misalignment;
+    int      fill;
+    int      length;
+    int      j;
+    double   value;
+    int64_t  currency;
+    uint64_t magnitude;
+    int      decimals;
+    int      failures = 0;
+    long     i;
+    static const double EDGECASES[] = {0.0, -0.0, 0.5, -0.5, 1.5, 2.5, 0.125, 1e-300, 5e-324, 9.2233720368547758e18,
+                                       1.8446744073709552e19, 1e22, 1.7976931348623157e308};
+
+    initoutbuf(&outbuf, -1, OUTBUFFLUSHSIZE);
+
+    for(i = 0; i < (long) (sizeof(EDGECASES) / sizeof(double)); i++) {
+        for(decimals = 0; decimals <= 25; decimals++) {
+            sprintf(expected, "%.*f", decimals, EDGECASES[i]);
+            sprintf(what, "outbuffixed(%a, %d)", EDGECASES[i], decimals);
+            outbuffixed(&outbuf, EDGECASES[i], decimals);
+            failures += checkoutput(&outbuf, expected, what);
+        }
+    }
+    for(i = 0; i < ITERATIONS && failures < 20; i++) {
+        value = randomdouble();
+        decimals = random64() % 21;
+        sprintf(expected, "%.*f", decimals, value);
+        sprintf(what, "outbuffixed(%a, %d)", value, decimals);
+        outbuffixed(&outbuf, value, decimals);
+        failures += checkoutput(&outbuf, expected, what);
+    }
+
+    for(i = 0; i < ITERATIONS && failures < 20; i++) {
+        currency = (int64_t) random64() >> (random64() % 64);
+        if(i == 0) {
+            currency = INT64_MIN;
+        }
+        magnitude = currency < 0 ? -(uint64_t) currency : (uint64_t) currency;
+        sprintf(expected, "%s%"PRIu64".%04"PRIu64, currency < 0 ? "-" : "", magnitude / 10000, magnitude % 10000);
+        sprintf(what, "outbufcurrency(%"PRId64")", currency);
+        outbufcurrency(&outbuf, currency);
+        failures += checkoutput(&outbuf, expected, what);
+    }
+
+    /* The hex encoder picked for this CPU has to match printf() at every
+     * length, so that its vector loops and the leftover bytes are both
+     * covered */
+    selectkernels();
+    for(i = 0; i < ITERATIONS / 100 && failures < 20; i++) {
+        length = random64() % sizeof(bytes);
+        for(j = 0; j < length; j++) {
+            bytes[j] = random64();
+            sprintf(expected + 2 * j, "%02x", (uint8_t) bytes[j]);
+        }
+        hexencode(hex, bytes, length);
+        if(memcmp(hex, expected, 2 * length)) {
+            fprintf(stderr, "hexencode() of %d bytes: expected \"%.*s\", got \"%.*s\"\n",
+                    length, 2 * length, expected, 2 * length, hex);
+            failures++;
+        }
+    }
+
+    /* So do the scanning kernels, at every length and alignment, with the
+     * bytes they look for in random places */
+    for(length = 0; length <= SCANMAXLENGTH && failures < 20; length++) {
+        for(misalignment = 0; misalignment < SCANMISALIGNMENTS; misalignment++) {
+            scanned = scanbuffer + misalignment;
+            for(fill = 0; fill < SCANFILLS; fill++) {
+                fillscanbuffer(scanned, length);
+                failures += checkscan("trimmedlength", scanned, length,
+                                      scalartrimmedlength(scanned, length), trimmedlength(scanned, length));
+                failures += checkscan("findescape", scanned, length,
+                                      scalarfindescape(scanned, length), findescape(scanned, length));
+                failures += checkscan("findnonascii", scanned, length,
+                                      scalarfindnonascii(scanned, length), findnonascii(scanned, length));
+            }
+        }
+    }
+
+    freeoutbuf(&outbuf);
+    if(failures) {
+        fprintf(stderr, "%d mismatches\n", failures);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,442 @@
+/* Generated by getcodepages.py. Do not edit. */
+
+/* Each table maps the bytes 0x80 through 0xFF of a codepage to UTF-8,
+ * as a length followed by up to three bytes. A length of 0 means that
+ * the codepage doesn't define that byte. The bytes below 0x80 are the
+ * same as ASCII in all of these codepages. */
+
+static const uint8_t CP437TOUTF8[128][4] = {
+    {2, 0xc3, 0x87}, {2, 0xc3, 0xbc}, {2, 0xc3, 0xa9}, {2, 0xc3, 0xa2},
+    {2, 0xc3, 0xa4}, {2, 0xc3, 0xa0}, {2, 0xc3, 0xa5}, {2, 0xc3, 0xa7},
+    {2, 0xc3, 0xaa}, {2, 0xc3, 0xab}, {2, 0xc3, 0xa8}, {2, 0xc3, 0xaf},
+    {2, 0xc3, 0xae}, {2, 0xc3, 0xac}, {2, 0xc3, 0x84}, {2, 0xc3, 0x85},
+    {2, 0xc3, 0x89}, {2, 0xc3, 0xa6}, {2, 0xc3, 0x86}, {2, 0xc3, 0xb4},
+    {2, 0xc3, 0xb6}, {2, 0xc3, 0xb2}, {2, 0xc3, 0xbb}, {2, 0xc3, 0xb9},
+    {2, 0xc3, 0xbf}, {2, 0xc3, 0x96}, {2, 0xc3, 0x9c}, {2, 0xc2, 0xa2},
+    {2, 0xc2, 0xa3}, {2, 0xc2, 0xa5}, {3, 0xe2, 0x82, 0xa7}, {2, 0xc6, 0x92},
+    {2, 0xc3, 0xa1}, {2, 0xc3, 0xad}, {2, 0xc3, 0xb3}, {2, 0xc3, 0xba},
+    {2, 0xc3, 0xb1}, {2, 0xc3, 0x91}, {2, 0xc2, 0xaa}, {2, 0xc2, 0xba},
+    {2, 0xc2, 0xbf}, {3, 0xe2, 0x8c, 0x90}, {2, 0xc2, 0xac}, {2, 0xc2, 0xbd},
+    {2, 0xc2, 0xbc}, {2, 0xc2, 0xa1}, {2, 0xc2, 0xab}, {2, 0xc2, 0xbb},
+    {3, 0xe2, 0x96, 0x91}, {3, 0xe2, 0x96, 0x92}, {3, 0xe2, 0x96, 0x93}, {3, 0xe2, 0x94, 0x82},
+    {3, 0xe2, 0x94, 0xa4}, {3, 0xe2, 0x95, 0xa1}, {3, 0xe2, 0x95, 0xa2}, {3, 0xe2, 0x95, 0x96},
+    {3, 0xe2, 0x95, 0x95}, {3, 0xe2, 0x95, 0xa3}, {3, 0xe2, 0x95, 0x91}, {3, 0xe2, 0x95, 0x97},
+    {3, 0xe2, 0x95, 0x9d}, {3, 0xe2, 0x95, 0x9c}, {3, 0xe2, 0x95, 0x9b}, {3, 0xe2, 0x94, 0x90},
+    {3, 0xe2, 0x94, 0x94}, {3, 0xe2, 0x94, 0xb4}, {3, 0xe2, 0x94, 0xac}, {3, 0xe2, 0x94, 0x9c},
+    {3, 0xe2, 0x94, 0x80}, {3, 0xe2, 0x94, 0xbc}, {3, 0xe2, 0x95, 0x9e}, {3, 0xe2, 0x95, 0x9f},
+    {3, 0xe2, 0x95, 0x9a}, {3, 0xe2, 0x95, 0x94}, {3, 0xe2, 0x95, 0xa9}, {3, 0xe2, 0x95, 0xa6},
+    {3, 0xe2, 0x95, 0xa0}, {3, 0xe2, 0x95, 0x90}, {3, 0xe2, 0x95, 0xac}, {3, 0xe2, 0x95, 0xa7},
+    {3, 0xe2, 0x95, 0xa8}, {3, 0xe2, 0x95, 0xa4}, {3, 0xe2, 0x95, 0xa5}, {3, 0xe2, 0x95, 0x99},
+    {3, 0xe2, 0x95, 0x98}, {3, 0xe2, 0x95, 0x92}, {3, 0xe2, 0x95, 0x93}, {3, 0xe2, 0x95, 0xab},
+    {3, 0xe2, 0x95, 0xaa}, {3, 0xe2, 0x94, 0x98}, {3, 0xe2, 0x94, 0x8c}, {3, 0xe2, 0x96, 0x88},
+    {3, 0xe2, 0x96, 0x84}, {3, 0xe2, 0x96, 0x8c}, {3, 0xe2, 0x96, 0x90}, {3, 0xe2, 0x96, 0x80},
+    {2, 0xce, 0xb1}, {2, 0xc3, 0x9f}, {2, 0xce, 0x93}, {2, 0xcf, 0x80},
+    {2, 0xce, 0xa3}, {2, 0xcf, 0x83}, {2, 0xc2, 0xb5}, {2, 0xcf, 0x84},
+    {2, 0xce, 0xa6}, {2, 0xce, 0x98}, {2, 0xce, 0xa9}, {2, 0xce, 0xb4},
+    {3, 0xe2, 0x88, 0x9e}, {2, 0xcf, 0x86}, {2, 0xce, 0xb5}, {3, 0xe2, 0x88, 0xa9},
+    {3, 0xe2, 0x89, 0xa1}, {2, 0xc2, 0xb1}, {3, 0xe2, 0x89, 0xa5}, {3, 0xe2, 0x89, 0xa4},
+    {3, 0xe2, 0x8c, 0xa0}, {3, 0xe2, 0x8c, 0xa1}, {2, 0xc3, 0xb7}, {3, 0xe2, 0x89, 0x88},
+    {2, 0xc2, 0xb0}, {3, 0xe2, 0x88, 0x99}, {2, 0xc2, 0xb7}, {3, 0xe2, 0x88, 0x9a},
+    {3, 0xe2, 0x81, 0xbf}, {2, 0xc2, 0xb2}, {3, 0xe2, 0x96, 0xa0}, {2, 0xc2, 0xa0},
+};
+
+static const uint8_t CP850TOUTF8[128][4] = {
+    {2, 0xc3, 0x87}, {2, 0xc3, 0xbc}, {2, 0xc3, 0xa9}, {2, 0xc3, 0xa2},
+    {2, 0xc3, 0xa4}, {2, 0xc3, 0xa0}, {2, 0xc3, 0xa5}, {2, 0xc3, 0xa7},
+    {2, 0xc3, 0xaa}, {2, 0xc3, 0xab}, {2, 0xc3, 0xa8}, {2, 0xc3, 0xaf},
+    {2, 0xc3, 0xae}, {2, 0xc3, 0xac}, {2, 0xc3, 0x84}, {2, 0xc3, 0x85},
+    {2, 0xc3, 0x89}, {2, 0xc3, 0xa6}, {2, 0xc3, 0x86}, {2, 0xc3, 0xb4},
+    {2, 0xc3, 0xb6}, {2, 0xc3, 0xb2}, {2, 0xc3, 0xbb}, {2, 0xc3, 0xb9},
+    {2, 0xc3, 0xbf}, {2, 0xc3, 0x96}, {2, 0xc3, 0x9c}, {2, 0xc3, 0xb8},
+    {2, 0xc2, 0xa3}, {2, 0xc3, 0x98}, {2, 0xc3, 0x97}, {2, 0xc6, 0x92},
+    {2, 0xc3, 0xa1}, {2, 0xc3, 0xad}, {2, 0xc3, 0xb3}, {2, 0xc3, 0xba},
+    {2, 0xc3, 0xb1}, {2, 0xc3, 0x91}, {2, 0xc2, 0xaa}, {2, 0xc2, 0xba},
+    {2, 0xc2, 0xbf}, {2, 0xc2, 0xae}, {2, 0xc2, 0xac}, {2, 0xc2, 0xbd},
+    {2, 0xc2, 0xbc}, {2, 0xc2, 0xa1}, {2, 0xc2, 0xab}, {2, 0xc2, 0xbb},
+    {3, 0xe2, 0x96, 0x91}, {3, 0xe2, 0x96, 0x92}, {3, 0xe2, 0x96, 0x93}, {3, 0xe2, 0x94, 0x82},
+    {3, 0xe2, 0x94, 0xa4}, {2, 0xc3, 0x81}, {2, 0xc3, 0x82}, {2, 0xc3, 0x80},
+    {2, 0xc2, 0xa9}, {3, 0xe2, 0x95, 0xa3}, {3, 0xe2, 0x95, 0x91}, {3, 0xe2, 0x95, 0x97},
+    {3, 0xe2, 0x95, 0x9d}, {2, 0xc2, 0xa2}, {2, 0xc2, 0xa5}, {3, 0xe2, 0x94, 0x90},
+    {3, 0xe2, 0x94, 0x94}, {3, 0xe2, 0x94, 0xb4}, {3, 0xe2, 0x94, 0xac}, {3, 0xe2, 0x94, 0x9c},
+    {3, 0xe2, 0x94, 0x80}, {3, 0xe2, 0x94, 0xbc}, {2, 0xc3, 0xa3}, {2, 0xc3, 0x83},
+    {3, 0xe2, 0x95, 0x9a}, {3, 0xe2, 0x95, 0x94}, {3, 0xe2, 0x95, 0xa9}, {3, 0xe2, 0x95, 0xa6},
+    {3, 0xe2, 0x95, 0xa0}, {3, 0xe2, 0x95, 0x90}, {3, 0xe2, 0x95, 0xac}, {2, 0xc2, 0xa4},
+    {2, 0xc3, 0xb0}, {2, 0xc3, 0x90}, {2, 0xc3, 0x8a}, {2, 0xc3, 0x8b},
+    {2, 0xc3, 0x88}, {2, 0xc4, 0xb1}, {2, 0xc3, 0x8d}, {2, 0xc3, 0x8e},
+    {2, 0xc3, 0x8f}, {3, 0xe2, 0x94, 0x98}, {3, 0xe2, 0x94, 0x8c}, {3, 0xe2, 0x96, 0x88},
+    {3, 0xe2, 0x96, 0x84}, {2, 0xc2, 0xa6}, {2, 0xc3, 0x8c}, {3, 0xe2, 0x96, 0x80},
+    {2, 0xc3, 0x93}, {2, 0xc3, 0x9f}, {2, 0xc3, 0x94}, {2, 0xc3, 0x92},
+    {2, 0xc3, 0xb5}, {2, 0xc3, 0x95}, {2, 0xc2, 0xb5}, {2, 0xc3, 0xbe},
+    {2, 0xc3, 0x9e}, {2, 0xc3, 0x9a}, {2, 0xc3, 0x9b}, {2, 0xc3, 0x99},
+    {2, 0xc3, 0xbd}, {2, 0xc3, 0x9d}, {2, 0xc2, 0xaf}, {2, 0xc2, 0xb4},
+    {2, 0xc2, 0xad}, {2, 0xc2, 0xb1}, {3, 0xe2, 0x80, 0x97}, {2, 0xc2, 0xbe},
+    {2, 0xc2, 0xb6}, {2, 0xc2, 0xa7}, {2, 0xc3, 0xb7}, {2, 0xc2, 0xb8},
+    {2, 0xc2, 0xb0}, {2, 0xc2, 0xa8}, {2, 0xc2, 0xb7}, {2, 0xc2, 0xb9},
+    {2, 0xc2, 0xb3}, {2, 0xc2, 0xb2}, {3, 0xe2, 0x96, 0xa0}, {2, 0xc2, 0xa0},
+};
+
+static const uint8_t CP852TOUTF8[128][4] = {
+    {2, 0xc3, 0x87}, {2, 0xc3, 0xbc}, {2, 0xc3, 0xa9}, {2, 0xc3, 0xa2},
+    {2, 0xc3, 0xa4}, {2, 0xc5, 0xaf}, {2, 0xc4, 0x87}, {2, 0xc3, 0xa7},
+    {2, 0xc5, 0x82}, {2, 0xc3, 0xab}, {2, 0xc5, 0x90}, {2, 0xc5, 0x91},
+    {2, 0xc3, 0xae}, {2, 0xc5, 0xb9}, {2, 0xc3, 0x84}, {2, 0xc4, 0x86},
+    {2, 0xc3, 0x89}, {2, 0xc4, 0xb9}, {2, 0xc4, 0xba}, {2, 0xc3, 0xb4},
+    {2, 0xc3, 0xb6}, {2, 0xc4, 0xbd}, {2, 0xc4, 0xbe}, {2, 0xc5, 0x9a},
+    {2, 0xc5, 0x9b}, {2, 0xc3, 0x96}, {2, 0xc3, 0x9c}, {2, 0xc5, 0xa4},
+    {2, 0xc5, 0xa5}, {2, 0xc5, 0x81}, {2, 0xc3, 0x97}, {2, 0xc4, 0x8d},
+    {2, 0xc3, 0xa1}, {2, 0xc3, 0xad}, {2, 0xc3, 0xb3}, {2, 0xc3, 0xba},
+    {2, 0xc4, 0x84}, {2, 0xc4, 0x85}, {2, 0xc5, 0xbd}, {2, 0xc5, 0xbe},
+    {2, 0xc4, 0x98}, {2, 0xc4, 0x99}, {2, 0xc2, 0xac}, {2, 0xc5, 0xba},
+    {2, 0xc4, 0x8c}, {2, 0xc5, 0x9f}, {2, 0xc2, 0xab}, {2, 0xc2, 0xbb},
+    {3, 0xe2, 0x96, 0x91}, {3, 0xe2, 0x96, 0x92}, {3, 0xe2, 0x96, 0x93}, {3, 0xe2, 0x94, 0x82},
+    {3, 0xe2, 0x94, 0xa4}, {2, 0xc3, 0x81}, {2, 0xc3, 0x82}, {2, 0xc4, 0x9a},
+    {2, 0xc5, 0x9e}, {3, 0xe2, 0x95, 0xa3}, {3, 0xe2, 0x95, 0x91}, {3, 0xe2, 0x95, 0x97},
+    {3, 0xe2, 0x95, 0x9d}, {2, 0xc5, 0xbb}, {2, 0xc5, 0xbc}, {3, 0xe2, 0x94, 0x90},
+    {3, 0xe2, 0x94, 0x94}, {3, 0xe2, 0x94, 0xb4}, {3, 0xe2, 0x94, 0xac}, {3, 0xe2, 0x94, 0x9c},
+    {3, 0xe2, 0x94, 0x80}, {3, 0xe2, 0x94, 0xbc}, {2, 0xc4, 0x82}, {2, 0xc4, 0x83},
+    {3, 0xe2, 0x95, 0x9a}, {3, 0xe2, 0x95, 0x94}, {3, 0xe2, 0x95, 0xa9}, {3, 0xe2, 0x95, 0xa6},
+    {3, 0xe2, 0x95, 0xa0}, {3, 0xe2, 0x95, 0x90}, {3, 0xe2, 0x95, 0xac}, {2, 0xc2, 0xa4},
+    {2, 0xc4, 0x91}, {2, 0xc4, 0x90}, {2, 0xc4, 0x8e}, {2, 0xc3, 0x8b},
+    {2, 0xc4, 0x8f}, {2, 0xc5, 0x87}, {2, 0xc3, 0x8d}, {2, 0xc3, 0x8e},
+    {2, 0xc4, 0x9b}, {3, 0xe2, 0x94, 0x98}, {3, 0xe2, 0x94, 0x8c}, {3, 0xe2, 0x96, 0x88},
+    {3, 0xe2, 0x96, 0x84}, {2, 0xc5, 0xa2}, {2, 0xc5, 0xae}, {3, 0xe2, 0x96, 0x80},
+    {2, 0xc3, 0x93}, {2, 0xc3, 0x9f}, {2, 0xc3, 0x94}, {2, 0xc5, 0x83},
+    {2, 0xc5, 0x84}, {2, 0xc5, 0x88}, {2, 0xc5, 0xa0}, {2, 0xc5, 0xa1},
+    {2, 0xc5, 0x94}, {2, 0xc3, 0x9a}, {2, 0xc5, 0x95}, {2, 0xc5, 0xb0},
+    {2, 0xc3, 0xbd}, {2, 0xc3, 0x9d}, {2, 0xc5, 0xa3}, {2, 0xc2, 0xb4},
+    {2, 0xc2, 0xad}, {2, 0xcb, 0x9d}, {2, 0xcb, 0x9b}, {2, 0xcb, 0x87},
+    {2, 0xcb, 0x98}, {2, 0xc2, 0xa7}, {2, 0xc3, 0xb7}, {2, 0xc2, 0xb8},
+    {2, 0xc2, 0xb0}, {2, 0xc2, 0xa8}, {2, 0xcb, 0x99}, {2, 0xc5, 0xb1},
+    {2, 0xc5, 0x98}, {2, 0xc5, 0x99}, {3, 0xe2, 0x96, 0xa0}, {2, 0xc2, 0xa0},
+};
+
+static const uint8_t CP865TOUTF8[128][4] = {
+    {2, 0xc3, 0x87}, {2, 0xc3, 0xbc}, {2, 0xc3, 0xa9}, {2, 0xc3, 0xa2},
+    {2, 0xc3, 0xa4}, {2, 0xc3, 0xa0}, {2, 0xc3, 0xa5}, {2, 0xc3, 0xa7},
+    {2, 0xc3, 0xaa}, {2, 0xc3, 0xab}, {2, 0xc3, 0xa8}, {2, 0xc3, 0xaf},
+    {2, 0xc3, 0xae}, {2, 0xc3, 0xac}, {2, 0xc3, 0x84}, {2, 0xc3, 0x85},
+    {2, 0xc3, 0x89}, {2, 0xc3, 0xa6}, {2, 0xc3, 0x86}, {2, 0xc3, 0xb4},
+    {2, 0xc3, 0xb6}, {2, 0xc3, 0xb2}, {2, 0xc3, 0xbb}, {2, 0xc3, 0xb9},
+    {2, 0xc3, 0xbf}, {2, 0xc3, 0x96}, {2, 0xc3, 0x9c}, {2, 0xc3, 0xb8},
+    {2, 0xc2, 0xa3}, {2, 0xc3, 0x98}, {3, 0xe2, 0x82, 0xa7}, {2, 0xc6, 0x92},
+    {2, 0xc3, 0xa1}, {2, 0xc3, 0xad}, {2, 0xc3, 0xb3}, {2, 0xc3, 0xba},
+    {2, 0xc3, 0xb1}, {2, 0xc3, 0x91}, {2, 0xc2, 0xaa}, {2, 0xc2, 0xba},
+    {2, 0xc2, 0xbf}, {3, 0xe2, 0x8c, 0x90}, {2, 0xc2, 0xac}, {2, 0xc2, 0xbd},
+    {2, 0xc2, 0xbc}, {2, 0xc2, 0xa1}, {2, 0xc2, 0xab}, {2, 0xc2, 0xa4},
+    {3, 0xe2, 0x96, 0x91}, {3, 0xe2, 0x96, 0x92}, {3, 0xe2, 0x96, 0x93}, {3, 0xe2, 0x94, 0x82},
+    {3, 0xe2, 0x94, 0xa4}, {3, 0xe2, 0x95, 0xa1}, {3, 0xe2, 0x95, 0xa2}, {3, 0xe2, 0x95, 0x96},
+    {3, 0xe2, 0x95, 0x95}, {3, 0xe2, 0x95, 0xa3}, {3, 0xe2, 0x95, 0x91}, {3, 0xe2, 0x95, 0x97},
+    {3, 0xe2, 0x95, 0x9d}, {3, 0xe2, 0x95, 0x9c}, {3, 0xe2, 0x95, 0x9b}, {3, 0xe2, 0x94, 0x90},
+    {3, 0xe2, 0x94, 0x94}, {3, 0xe2, 0x94, 0xb4}, {3, 0xe2, 0x94, 0xac}, {3, 0xe2, 0x94, 0x9c},
+    {3, 0xe2, 0x94, 0x80}, {3, 0xe2, 0x94, 0xbc}, {3, 0xe2, 0x95, 0x9e}, {3, 0xe2, 0x95, 0x9f},
+    {3, 0xe2, 0x95, 0x9a}, {3, 0xe2, 0x95, 0x94}, {3, 0xe2, 0x95, 0xa9}, {3, 0xe2, 0x95, 0xa6},
+    {3, 0xe2, 0x95, 0xa0}, {3, 0xe2, 0x95, 0x90}, {3, 0xe2, 0x95, 0xac}, {3, 0xe2, 0x95, 0xa7},
+    {3, 0xe2, 0x95, 0xa8}, {3, 0xe2, 0x95, 0xa4}, {3, 0xe2, 0x95, 0xa5}, {3, 0xe2, 0x95, 0x99},
+    {3, 0xe2, 0x95, 0x98}, {3, 0xe2, 0x95, 0x92}, {3, 0xe2, 0x95, 0x93}, {3, 0xe2, 0x95, 0xab},
+    {3, 0xe2, 0x95, 0xaa}, {3, 0xe2, 0x94, 0x98}, {3, 0xe2, 0x94, 0x8c}, {3, 0xe2, 0x96, 0x88},
+    {3, 0xe2, 0x96, 0x84}, {3, 0xe2, 0x96, 0x8c}, {3, 0xe2, 0x96, 0x90}, {3, 0xe2, 0x96, 0x80},
+    {2, 0xce, 0xb1}, {2, 0xc3, 0x9f}, {2, 0xce, 0x93}, {2, 0xcf, 0x80},
+    {2, 0xce, 0xa3}, {2, 0xcf, 0x83}, {2, 0xc2, 0xb5}, {2, 0xcf, 0x84},
+    {2, 0xce, 0xa6}, {2, 0xce, 0x98}, {2, 0xce, 0xa9}, {2, 0xce, 0xb4},
+    {3, 0xe2, 0x88, 0x9e}, {2, 0xcf, 0x86}, {2, 0xce, 0xb5}, {3, 0xe2, 0x88, 0xa9},
+    {3, 0xe2, 0x89, 0xa1}, {2, 0xc2, 0xb1}, {3, 0xe2, 0x89, 0xa5}, {3, 0xe2, 0x89, 0xa4},
+    {3, 0xe2, 0x8c, 0xa0}, {3, 0xe2, 0x8c, 0xa1}, {2, 0xc3, 0xb7}, {3, 0xe2, 0x89, 0x88},
+    {2, 0xc2, 0xb0}, {3, 0xe2, 0x88, 0x99}, {2, 0xc2, 0xb7}, {3, 0xe2, 0x88, 0x9a},
+    {3, 0xe2, 0x81, 0xbf}, {2, 0xc2, 0xb2}, {3, 0xe2, 0x96, 0xa0}, {2, 0xc2, 0xa0},
+};
+
+static const uint8_t CP866TOUTF8[128][4] = {
+    {2, 0xd0, 0x90}, {2, 0xd0, 0x91}, {2, 0xd0, 0x92}, {2, 0xd0, 0x93},
+    {2, 0xd0, 0x94}, {2, 0xd0, 0x95}, {2, 0xd0, 0x96}, {2, 0xd0, 0x97},
+    {2, 0xd0, 0x98}, {2, 0xd0, 0x99}, {2, 0xd0, 0x9a}, {2, 0xd0, 0x9b},
+    {2, 0xd0, 0x9c}, {2, 0xd0, 0x9d}, {2, 0xd0, 0x9e}, {2, 0xd0, 0x9f},
+    {2, 0xd0, 0xa0}, {2, 0xd0, 0xa1}, {2, 0xd0, 0xa2}, {2, 0xd0, 0xa3},
+    {2, 0xd0, 0xa4}, {2, 0xd0, 0xa5}, {2, 0xd0, 0xa6}, {2, 0xd0, 0xa7},
+    {2, 0xd0, 0xa8}, {2, 0xd0, 0xa9}, {2, 0xd0, 0xaa}, {2, 0xd0, 0xab},
+    {2, 0xd0, 0xac}, {2, 0xd0, 0xad}, {2, 0xd0, 0xae}, {2, 0xd0, 0xaf},
+    {2, 0xd0, 0xb0}, {2, 0xd0, 0xb1}, {2, 0xd0, 0xb2}, {2, 0xd0, 0xb3},
+    {2, 0xd0, 0xb4}, {2, 0xd0, 0xb5}, {2, 0xd0, 0xb6}, {2, 0xd0, 0xb7},
+    {2, 0xd0, 0xb8}, {2, 0xd0, 0xb9}, {2, 0xd0, 0xba}, {2, 0xd0, 0xbb},
+    {2, 0xd0, 0xbc}, {2, 0xd0, 0xbd}, {2, 0xd0, 0xbe}, {2, 0xd0, 0xbf},
+    {3, 0xe2, 0x96, 0x91}, {3, 0xe2, 0x96, 0x92}, {3, 0xe2, 0x96, 0x93}, {3, 0xe2, 0x94, 0x82},
+    {3, 0xe2, 0x94, 0xa4}, {3, 0xe2, 0x95, 0xa1}, {3, 0xe2, 0x95, 0xa2}, {3, 0xe2, 0x95, 0x96},
+    {3, 0xe2, 0x95, 0x95}, {3, 0xe2, 0x95, 0xa3}, {3, 0xe2, 0x95, 0x91}, {3, 0xe2, 0x95, 0x97},
+    {3, 0xe2, 0x95, 0x9d}, {3, 0xe2, 0x95, 0x9c}, {3, 0xe2, 0x95, 0x9b}, {3, 0xe2, 0x94, 0x90},
+    {3, 0xe2, 0x94, 0x94}, {3, 0xe2, 0x94, 0xb4}, {3, 0xe2, 0x94, 0xac}, {3, 0xe2, 0x94, 0x9c},
+    {3, 0xe2, 0x94, 0x80}, {3, 0xe2, 0x94, 0xbc}, {3, 0xe2, 0x95, 0x9e}, {3, 0xe2, 0x95, 0x9f},
+    {3, 0xe2, 0x95, 0x9a}, {3, 0xe2, 0x95, 0x94}, {3, 0xe2, 0x95, 0xa9}, {3, 0xe2, 0x95, 0xa6},
+    {3, 0xe2, 0x95, 0xa0}, {3, 0xe2, 0x95, 0x90}, {3, 0xe2, 0x95, 0xac}, {3, 0xe2, 0x95, 0xa7},
+    {3, 0xe2, 0x95, 0xa8}, {3, 0xe2, 0x95, 0xa4}, {3, 0xe2, 0x95, 0xa5}, {3, 0xe2, 0x95, 0x99},
+    {3, 0xe2, 0x95, 0x98}, {3, 0xe2, 0x95, 0x92}, {3, 0xe2, 0x95, 0x93}, {3, 0xe2, 0x95, 0xab},
+    {3, 0xe2, 0x95, 0xaa}, {3, 0xe2, 0x94, 0x98}, {3, 0xe2, 0x94, 0x8c}, {3, 0xe2, 0x96, 0x88},
+    {3, 0xe2, 0x96, 0x84}, {3, 0xe2, 0x96, 0x8c}, {3, 0xe2, 0x96, 0x90}, {3, 0xe2, 0x96, 0x80},
+    {2, 0xd1, 0x80}, {2, 0xd1, 0x81}, {2, 0xd1, 0x82}, {2, 0xd1, 0x83},
+    {2, 0xd1, 0x84}, {2, 0xd1, 0x85}, {2, 0xd1, 0x86}, {2, 0xd1, 0x87},
+    {2, 0xd1, 0x88}, {2, 0xd1, 0x89}, {2, 0xd1, 0x8a}, {2, 0xd1, 0x8b},
+    {2, 0xd1, 0x8c}, {2, 0xd1, 0x8d}, {2, 0xd1, 0x8e}, {2, 0xd1, 0x8f},
+    {2, 0xd0, 0x81}, {2, 0xd1, 0x91}, {2, 0xd0, 0x84}, {2, 0xd1, 0x94},
+    {2, 0xd0, 0x87}, {2, 0xd1, 0x97}, {2, 0xd0, 0x8e}, {2, 0xd1, 0x9e},
+    {2, 0xc2, 0xb0}, {3, 0xe2, 0x88, 0x99}, {2, 0xc2, 0xb7}, {3, 0xe2, 0x88, 0x9a},
+    {3, 0xe2, 0x84, 0x96}, {2, 0xc2, 0xa4}, {3, 0xe2, 0x96, 0xa0}, {2, 0xc2, 0xa0},
+};
+
+static const uint8_t CP1250TOUTF8[128][4] = {
+    {3, 0xe2, 0x82, 0xac}, {0}, {3, 0xe2, 0x80, 0x9a}, {0},
+    {3, 0xe2, 0x80, 0x9e}, {3, 0xe2, 0x80, 0xa6}, {3, 0xe2, 0x80, 0xa0}, {3, 0xe2, 0x80, 0xa1},
+    {0}, {3, 0xe2, 0x80, 0xb0}, {2, 0xc5, 0xa0}, {3, 0xe2, 0x80, 0xb9},
+    {2, 0xc5, 0x9a}, {2, 0xc5, 0xa4}, {2, 0xc5, 0xbd}, {2, 0xc5, 0xb9},
+    {0}, {3, 0xe2, 0x80, 0x98}, {3, 0xe2, 0x80, 0x99}, {3, 0xe2, 0x80, 0x9c},
+    {3, 0xe2, 0x80, 0x9d}, {3, 0xe2, 0x80, 0xa2}, {3, 0xe2, 0x80, 0x93}, {3, 0xe2, 0x80, 0x94},
+    {0}, {3, 0xe2, 0x84, 0xa2}, {2, 0xc5, 0xa1}, {3, 0xe2, 0x80, 0xba},
+    {2, 0xc5, 0x9b}, {2, 0xc5, 0xa5}, {2, 0xc5, 0xbe}, {2, 0xc5, 0xba},
+    {2, 0xc2, 0xa0}, {2, 0xcb, 0x87}, {2, 0xcb, 0x98}, {2, 0xc5, 0x81},
+    {2, 0xc2, 0xa4}, {2, 0xc4, 0x84}, {2, 0xc2, 0xa6}, {2, 0xc2, 0xa7},
+    {2, 0xc2, 0xa8}, {2, 0xc2, 0xa9}, {2, 0xc5, 0x9e}, {2, 0xc2, 0xab},
+    {2, 0xc2, 0xac}, {2, 0xc2, 0xad}, {2, 0xc2, 0xae}, {2, 0xc5, 0xbb},
+    {2, 0xc2, 0xb0}, {2, 0xc2, 0xb1}, {2, 0xcb, 0x9b}, {2, 0xc5, 0x82},
+    {2, 0xc2, 0xb4}, {2, 0xc2, 0xb5}, {2, 0xc2, 0xb6}, {2, 0xc2, 0xb7},
+    {2, 0xc2, 0xb8}, {2, 0xc4, 0x85}, {2, 0xc5, 0x9f}, {2, 0xc2, 0xbb},
+    {2, 0xc4, 0xbd}, {2, 0xcb, 0x9d}, {2, 0xc4, 0xbe}, {2, 0xc5, 0xbc},
+    {2, 0xc5, 0x94}, {2, 0xc3, 0x81}, {2, 0xc3, 0x82}, {2, 0xc4, 0x82},
+    {2, 0xc3, 0x84}, {2, 0xc4, 0xb9}, {2, 0xc4, 0x86}, {2, 0xc3, 0x87},
+    {2, 0xc4, 0x8c}, {2, 0xc3, 0x89}, {2, 0xc4, 0x98}, {2, 0xc3, 0x8b},
+    {2, 0xc4, 0x9a}, {2, 0xc3, 0x8d}, {2, 0xc3, 0x8e}, {2, 0xc4, 0x8e},
+    {2, 0xc4, 0x90}, {2, 0xc5, 0x83}, {2, 0xc5, 0x87}, {2, 0xc3, 0x93},
+    {2, 0xc3, 0x94}, {2, 0xc5, 0x90}, {2, 0xc3, 0x96}, {2, 0xc3, 0x97},
+    {2, 0xc5, 0x98}, {2, 0xc5, 0xae}, {2, 0xc3, 0x9a}, {2, 0xc5, 0xb0},
+    {2, 0xc3, 0x9c}, {2, 0xc3, 0x9d}, {2, 0xc5, 0xa2}, {2, 0xc3, 0x9f},
+    {2, 0xc5, 0x95}, {2, 0xc3, 0xa1}, {2, 0xc3, 0xa2}, {2, 0xc4, 0x83},
+    {2, 0xc3, 0xa4}, {2, 0xc4, 0xba}, {2, 0xc4, 0x87}, {2, 0xc3, 0xa7},
+    {2, 0xc4, 0x8d}, {2, 0xc3, 0xa9}, {2, 0xc4, 0x99}, {2, 0xc3, 0xab},
+    {2, 0xc4, 0x9b}, {2, 0xc3, 0xad}, {2, 0xc3, 0xae}, {2, 0xc4, 0x8f},
+    {2, 0xc4, 0x91}, {2, 0xc5, 0x84}, {2, 0xc5, 0x88}, {2, 0xc3, 0xb3},
+    {2, 0xc3, 0xb4}, {2, 0xc5, 0x91}, {2, 0xc3, 0xb6}, {2, 0xc3, 0xb7},
+    {2, 0xc5, 0x99}, {2, 0xc5, 0xaf}, {2, 0xc3, 0xba}, {2, 0xc5, 0xb1},
+    {2, 0xc3, 0xbc}, {2, 0xc3, 0xbd}, {2, 0xc5, 0xa3}, {2, 0xcb, 0x99},
+};
+
+static const uint8_t CP1251TOUTF8[128][4] = {
+    {2, 0xd0, 0x82}, {2, 0xd0, 0x83}, {3, 0xe2, 0x80, 0x9a}, {2, 0xd1, 0x93},
+    {3, 0xe2, 0x80, 0x9e}, {3, 0xe2, 0x80, 0xa6}, {3, 0xe2, 0x80, 0xa0}, {3, 0xe2, 0x80, 0xa1},
+    {3, 0xe2, 0x82, 0xac}, {3, 0xe2, 0x80, 0xb0}, {2, 0xd0, 0x89}, {3, 0xe2, 0x80, 0xb9},
+    {2, 0xd0, 0x8a}, {2, 0xd0, 0x8c}, {2, 0xd0, 0x8b}, {2, 0xd0, 0x8f},
+    {2, 0xd1, 0x92}, {3, 0xe2, 0x80, 0x98}, {3, 0xe2, 0x80, 0x99}, {3, 0xe2, 0x80, 0x9c},
+    {3, 0xe2, 0x80, 0x9d}, {3, 0xe2, 0x80, 0xa2}, {3, 0xe2, 0x80, 0x93}, {3, 0xe2, 0x80, 0x94},
+    {0}, {3, 0xe2, 0x84, 0xa2}, {2, 0xd1, 0x99}, {3, 0xe2, 0x80, 0xba},
+    {2, 0xd1, 0x9a}, {2, 0xd1, 0x9c}, {2, 0xd1, 0x9b}, {2, 0xd1, 0x9f},
+    {2, 0xc2, 0xa0}, {2, 0xd0, 0x8e}, {2, 0xd1, 0x9e}, {2, 0xd0, 0x88},
+    {2, 0xc2, 0xa4}, {2, 0xd2, 0x90}, {2, 0xc2, 0xa6}, {2, 0xc2, 0xa7},
+    {2, 0xd0, 0x81}, {2, 0xc2, 0xa9}, {2, 0xd0, 0x84}, {2, 0xc2, 0xab},
+    {2, 0xc2, 0xac}, {2, 0xc2, 0xad}, {2, 0xc2, 0xae}, {2, 0xd0, 0x87},
+    {2, 0xc2, 0xb0}, {2, 0xc2, 0xb1}, {2, 0xd0, 0x86}, {2, 0xd1, 0x96},
+    {2, 0xd2, 0x91}, {2, 0xc2, 0xb5}, {2, 0xc2, 0xb6}, {2, 0xc2, 0xb7},
+    {2, 0xd1, 0x91}, {3, 0xe2, 0x84, 0x96}, {2, 0xd1, 0x94}, {2, 0xc2, 0xbb},
+    {2, 0xd1, 0x98}, {2, 0xd0, 0x85}, {2, 0xd1, 0x95}, {2, 0xd1, 0x97},
+    {2, 0xd0, 0x90}, {2, 0xd0, 0x91}, {2, 0xd0, 0x92}, {2, 0xd0, 0x93},
+    {2, 0xd0, 0x94}, {2, 0xd0, 0x95}, {2, 0xd0, 0x96}, {2, 0xd0, 0x97},
+    {2, 0xd0, 0x98}, {2, 0xd0, 0x99}, {2, 0xd0, 0x9a}, {2, 0xd0, 0x9b},
+    {2, 0xd0, 0x9c}, {2, 0xd0, 0x9d}, {2, 0xd0, 0x9e}, {2, 0xd0, 0x9f},
+    {2, 0xd0, 0xa0}, {2, 0xd0, 0xa1}, {2, 0xd0, 0xa2}, {2, 0xd0, 0xa3},
+    {2, 0xd0, 0xa4}, {2, 0xd0, 0xa5}, {2, 0xd0, 0xa6}, {2, 0xd0, 0xa7},
+    {2, 0xd0, 0xa8}, {2, 0xd0, 0xa9}, {2, 0xd0, 0xaa}, {2, 0xd0, 0xab},
+    {2, 0xd0, 0xac}, {2, 0xd0, 0xad}, {2, 0xd0, 0xae}, {2, 0xd0, 0xaf},
+    {2, 0xd0, 0xb0}, {2, 0xd0, 0xb1}, {2, 0xd0, 0xb2}, {2, 0xd0, 0xb3},
+    {2, 0xd0, 0xb4}, {2, 0xd0, 0xb5}, {2, 0xd0, 0xb6}, {2, 0xd0, 0xb7},
+    {2, 0xd0, 0xb8}, {2, 0xd0, 0xb9}, {2, 0xd0, 0xba}, {2, 0xd0, 0xbb},
+    {2, 0xd0, 0xbc}, {2, 0xd0, 0xbd}, {2, 0xd0, 0xbe}, {2, 0xd0, 0xbf},
+    {2, 0xd1, 0x80}, {2, 0xd1, 0x81}, {2, 0xd1, 0x82}, {2, 0xd1, 0x83},
+    {2, 0xd1, 0x84}, {2, 0xd1, 0x85}, {2, 0xd1, 0x86}, {2, 0xd1, 0x87},
+    {2, 0xd1, 0x88}, {2, 0xd1, 0x89}, {2, 0xd1, 0x8a}, {2, 0xd1, 0x8b},
+    {2, 0xd1, 0x8c}, {2, 0xd1, 0x8d}, {2, 0xd1, 0x8e}, {2, 0xd1, 0x8f},
+};
+
+static const uint8_t CP1252TOUTF8[128][4] = {
+    {3, 0xe2, 0x82, 0xac}, {0}, {3, 0xe2, 0x80, 0x9a}, {2, 0xc6, 0x92},
+    {3, 0xe2, 0x80, 0x9e}, {3, 0xe2, 0x80, 0xa6}, {3, 0xe2, 0x80, 0xa0}, {3, 0xe2, 0x80, 0xa1},
+    {2, 0xcb, 0x86}, {3, 0xe2, 0x80, 0xb0}, {2, 0xc5, 0xa0}, {3, 0xe2, 0x80, 0xb9},
+    {2, 0xc5, 0x92}, {0}, {2, 0xc5, 0xbd}, {0},
+    {0}, {3, 0xe2, 0x80, 0x98}, {3, 0xe2, 0x80, 0x99}, {3, 0xe2, 0x80, 0x9c},
+    {3, 0xe2, 0x80, 0x9d}, {3, 0xe2, 0x80, 0xa2}, {3, 0xe2, 0x80, 0x93}, {3, 0xe2, 0x80, 0x94},
+    {2, 0xcb, 0x9c}, {3, 0xe2, 0x84, 0xa2}, {2, 0xc5, 0xa1}, {3, 0xe2, 0x80, 0xba},
+    {2, 0xc5, 0x93}, {0}, {2, 0xc5, 0xbe}, {2, 0xc5, 0xb8},
+    {2, 0xc2, 0xa0}, {2, 0xc2, 0xa1}, {2, 0xc2, 0xa2}, {2, 0xc2, 0xa3},
+    {2, 0xc2, 0xa4}, {2, 0xc2, 0xa5}, {2, 0xc2, 0xa6}, {2, 0xc2, 0xa7},
+    {2, 0xc2, 0xa8}, {2, 0xc2, 0xa9}, {2, 0xc2, 0xaa}, {2, 0xc2, 0xab},
+    {2, 0xc2, 0xac}, {2, 0xc2, 0xad}, {2, 0xc2, 0xae}, {2, 0xc2, 0xaf},
+    {2, 0xc2, 0xb0}, {2, 0xc2, 0xb1}, {2, 0xc2, 0xb2}, {2, 0xc2, 0xb3},
+    {2, 0xc2, 0xb4}, {2, 0xc2, 0xb5}, {2, 0xc2, 0xb6}, {2, 0xc2, 0xb7},
+    {2, 0xc2, 0xb8}, {2, 0xc2, 0xb9}, {2, 0xc2, 0xba}, {2, 0xc2, 0xbb},
+    {2, 0xc2, 0xbc}, {2, 0xc2, 0xbd}, {2, 0xc2, 0xbe}, {2, 0xc2, 0xbf},
+    {2, 0xc3, 0x80}, {2, 0xc3, 0x81}, {2, 0xc3, 0x82}, {2, 0xc3, 0x83},
+    {2, 0xc3, 0x84}, {2, 0xc3, 0x85}, {2, 0xc3, 0x86}, {2, 0xc3, 0x87},
+    {2, 0xc3, 0x88}, {2, 0xc3, 0x89}, {2, 0xc3, 0x8a}, {2, 0xc3, 0x8b},
+    {2, 0xc3, 0x8c}, {2, 0xc3, 0x8d}, {2, 0xc3, 0x8e}, {2, 0xc3, 0x8f},
+    {2, 0xc3, 0x90}, {2, 0xc3, 0x91}, {2, 0xc3, 0x92}, {2, 0xc3, 0x93},
+    {2, 0xc3, 0x94}, {2, 0xc3, 0x95}, {2, 0xc3, 0x96}, {2, 0xc3, 0x97},
+    {2, 0xc3, 0x98}, {2, 0xc3, 0x99}, {2, 0xc3, 0x9a}, {2, 0xc3, 0x9b},
+    {2, 0xc3, 0x9c}, {2, 0xc3, 0x9d}, {2, 0xc3, 0x9e}, {2, 0xc3, 0x9f},
+    {2, 0xc3, 0xa0}, {2, 0xc3, 0xa1}, {2, 0xc3, 0xa2}, {2, 0xc3, 0xa3},
+    {2, 0xc3, 0xa4}, {2, 0xc3, 0xa5}, {2, 0xc3, 0xa6}, {2, 0xc3, 0xa7},
+    {2, 0xc3, 0xa8}, {2, 0xc3, 0xa9}, {2, 0xc3, 0xaa}, {2, 0xc3, 0xab},
+    {2, 0xc3, 0xac}, {2, 0xc3, 0xad}, {2, 0xc3, 0xae}, {2, 0xc3, 0xaf},
+    {2, 0xc3, 0xb0}, {2, 0xc3, 0xb1}, {2, 0xc3, 0xb2}, {2, 0xc3, 0xb3},
+    {2, 0xc3, 0xb4}, {2, 0xc3, 0xb5}, {2, 0xc3, 0xb6}, {2, 0xc3, 0xb7},
+    {2, 0xc3, 0xb8}, {2, 0xc3, 0xb9}, {2, 0xc3, 0xba}, {2, 0xc3, 0xbb},
+    {2, 0xc3, 0xbc}, {2, 0xc3, 0xbd}, {2, 0xc3, 0xbe}, {2, 0xc3, 0xbf},
+};
+
+static const uint8_t CP1253TOUTF8[128][4] = {
+    {3, 0xe2, 0x82, 0xac}, {0}, {3, 0xe2, 0x80, 0x9a}, {2, 0xc6, 0x92},
+    {3, 0xe2, 0x80, 0x9e}, {3, 0xe2, 0x80, 0xa6}, {3, 0xe2, 0x80, 0xa0}, {3, 0xe2, 0x80, 0xa1},
+    {0}, {3, 0xe2, 0x80, 0xb0}, {0}, {3, 0xe2, 0x80, 0xb9},
+    {0}, {0}, {0}, {0},
+    {0}, {3, 0xe2, 0x80, 0x98}, {3, 0xe2, 0x80, 0x99}, {3, 0xe2, 0x80, 0x9c},
+    {3, 0xe2, 0x80, 0x9d}, {3, 0xe2, 0x80, 0xa2}, {3, 0xe2, 0x80, 0x93}, {3, 0xe2, 0x80, 0x94},
+    {0}, {3, 0xe2, 0x84, 0xa2}, {0}, {3, 0xe2, 0x80, 0xba},
+    {0}, {0}, {0}, {0},
+    {2, 0xc2, 0xa0}, {2, 0xce, 0x85}, {2, 0xce, 0x86}, {2, 0xc2, 0xa3},
+    {2, 0xc2, 0xa4}, {2, 0xc2, 0xa5}, {2, 0xc2, 0xa6}, {2, 0xc2, 0xa7},
+    {2, 0xc2, 0xa8}, {2, 0xc2, 0xa9}, {0}, {2, 0xc2, 0xab},
+    {2, 0xc2, 0xac}, {2, 0xc2, 0xad}, {2, 0xc2, 0xae}, {3, 0xe2, 0x80, 0x95},
+    {2, 0xc2, 0xb0}, {2, 0xc2, 0xb1}, {2, 0xc2, 0xb2}, {2, 0xc2, 0xb3},
+    {2, 0xce, 0x84}, {2, 0xc2, 0xb5}, {2, 0xc2, 0xb6}, {2, 0xc2, 0xb7},
+    {2, 0xce, 0x88}, {2, 0xce, 0x89}, {2, 0xce, 0x8a}, {2, 0xc2, 0xbb},
+    {2, 0xce, 0x8c}, {2, 0xc2, 0xbd}, {2, 0xce, 0x8e}, {2, 0xce, 0x8f},
+    {2, 0xce, 0x90}, {2, 0xce, 0x91}, {2, 0xce, 0x92}, {2, 0xce, 0x93},
+    {2, 0xce, 0x94}, {2, 0xce, 0x95}, {2, 0xce, 0x96}, {2, 0xce, 0x97},
+    {2, 0xce, 0x98}, {2, 0xce, 0x99}, {2, 0xce, 0x9a}, {2, 0xce, 0x9b},
+    {2, 0xce, 0x9c}, {2, 0xce, 0x9d}, {2, 0xce, 0x9e}, {2, 0xce, 0x9f},
+    {2, 0xce, 0xa0}, {2, 0xce, 0xa1}, {0}, {2, 0xce, 0xa3},
+    {2, 0xce, 0xa4}, {2, 0xce, 0xa5}, {2, 0xce, 0xa6}, {2, 0xce, 0xa7},
+    {2, 0xce, 0xa8}, {2, 0xce, 0xa9}, {2, 0xce, 0xaa}, {2, 0xce, 0xab},
+    {2, 0xce, 0xac}, {2, 0xce, 0xad}, {2, 0xce, 0xae}, {2, 0xce, 0xaf},
+    {2, 0xce, 0xb0}, {2, 0xce, 0xb1}, {2, 0xce, 0xb2}, {2, 0xce, 0xb3},
+    {2, 0xce, 0xb4}, {2, 0xce, 0xb5}, {2, 0xce, 0xb6}, {2, 0xce, 0xb7},
+    {2, 0xce, 0xb8}, {2, 0xce, 0xb9}, {2, 0xce, 0xba}, {2, 0xce, 0xbb},
+    {2, 0xce, 0xbc}, {2, 0xce, 0xbd}, {2, 0xce, 0xbe}, {2, 0xce, 0xbf},
+    {2, 0xcf, 0x80}, {2, 0xcf, 0x81}, {2, 0xcf, 0x82}, {2, 0xcf, 0x83},
+    {2, 0xcf, 0x84}, {2, 0xcf, 0x85}, {2, 0xcf, 0x86}, {2, 0xcf, 0x87},
+    {2, 0xcf, 0x88}, {2, 0xcf, 0x89}, {2, 0xcf, 0x8a}, {2, 0xcf, 0x8b},
+    {2, 0xcf, 0x8c}, {2, 0xcf, 0x8d}, {2, 0xcf, 0x8e}, {0},
+};
+
+static const uint8_t CP1254TOUTF8[128][4] = {
+    {3, 0xe2, 0x82, 0xac}, {0}, {3, 0xe2, 0x80, 0x9a}, {2, 0xc6, 0x92},
+    {3, 0xe2, 0x80, 0x9e}, {3, 0xe2, 0x80, 0xa6}, {3, 0xe2, 0x80, 0xa0}, {3, 0xe2, 0x80, 0xa1},
+    {2, 0xcb, 0x86}, {3, 0xe2, 0x80, 0xb0}, {2, 0xc5, 0xa0}, {3, 0xe2, 0x80, 0xb9},
+    {2, 0xc5, 0x92}, {0}, {0}, {0},
+    {0}, {3, 0xe2, 0x80, 0x98}, {3, 0xe2, 0x80, 0x99}, {3, 0xe2, 0x80, 0x9c},
+    {3, 0xe2, 0x80, 0x9d}, {3, 0xe2, 0x80, 0xa2}, {3, 0xe2, 0x80, 0x93}, {3, 0xe2, 0x80, 0x94},
+    {2, 0xcb, 0x9c}, {3, 0xe2, 0x84, 0xa2}, {2, 0xc5, 0xa1}, {3, 0xe2, 0x80, 0xba},
+    {2, 0xc5, 0x93}, {0}, {0}, {2, 0xc5, 0xb8},
+    {2, 0xc2, 0xa0}, {2, 0xc2, 0xa1}, {2, 0xc2, 0xa2}, {2, 0xc2, 0xa3},
+    {2, 0xc2, 0xa4}, {2, 0xc2, 0xa5}, {2, 0xc2, 0xa6}, {2, 0xc2, 0xa7},
+    {2, 0xc2, 0xa8}, {2, 0xc2, 0xa9}, {2, 0xc2, 0xaa}, {2, 0xc2, 0xab},
+    {2, 0xc2, 0xac}, {2, 0xc2, 0xad}, {2, 0xc2, 0xae}, {2, 0xc2, 0xaf},
+    {2, 0xc2, 0xb0}, {2, 0xc2, 0xb1}, {2, 0xc2, 0xb2}, {2, 0xc2, 0xb3},
+    {2, 0xc2, 0xb4}, {2, 0xc2, 0xb5}, {2, 0xc2, 0xb6}, {2, 0xc2, 0xb7},
+    {2, 0xc2, 0xb8}, {2, 0xc2, 0xb9}, {2, 0xc2, 0xba}, {2, 0xc2, 0xbb},
+    {2, 0xc2, 0xbc}, {2, 0xc2, 0xbd}, {2, 0xc2, 0xbe}, {2, 0xc2, 0xbf},
+    {2, 0xc3, 0x80}, {2, 0xc3, 0x81}, {2, 0xc3, 0x82}, {2, 0xc3, 0x83},
+    {2, 0xc3, 0x84}, {2, 0xc3, 0x85}, {2, 0xc3, 0x86}, {2, 0xc3, 0x87},
+    {2, 0xc3, 0x88}, {2, 0xc3, 0x89}, {2, 0xc3, 0x8a}, {2, 0xc3, 0x8b},
+    {2, 0xc3, 0x8c}, {2, 0xc3, 0x8d}, {2, 0xc3, 0x8e}, {2, 0xc3, 0x8f},
+    {2, 0xc4, 0x9e}, {2, 0xc3, 0x91}, {2, 0xc3, 0x92}, {2, 0xc3, 0x93},
+    {2, 0xc3, 0x94}, {2, 0xc3, 0x95}, {2, 0xc3, 0x96}, {2, 0xc3, 0x97},
+    {2, 0xc3, 0x98}, {2, 0xc3, 0x99}, {2, 0xc3, 0x9a}, {2, 0xc3, 0x9b},
+    {2, 0xc3, 0x9c}, {2, 0xc4, 0xb0}, {2, 0xc5, 0x9e}, {2, 0xc3, 0x9f},
+    {2, 0xc3, 0xa0}, {2, 0xc3, 0xa1}, {2, 0xc3, 0xa2}, {2, 0xc3, 0xa3},
+    {2, 0xc3, 0xa4}, {2, 0xc3, 0xa5}, {2, 0xc3, 0xa6}, {2, 0xc3, 0xa7},
+    {2, 0xc3, 0xa8}, {2, 0xc3, 0xa9}, {2, 0xc3, 0xaa}, {2, 0xc3, 0xab},
+    {2, 0xc3, 0xac}, {2, 0xc3, 0xad}, {2, 0xc3, 0xae}, {2, 0xc3, 0xaf},
+    {2, 0xc4, 0x9f}, {2, 0xc3, 0xb1}, {2, 0xc3, 0xb2}, {2, 0xc3, 0xb3},
+    {2, 0xc3, 0xb4}, {2, 0xc3, 0xb5}, {2, 0xc3, 0xb6}, {2, 0xc3, 0xb7},
+    {2, 0xc3, 0xb8}, {2, 0xc3, 0xb9}, {2, 0xc3, 0xba}, {2, 0xc3, 0xbb},
+    {2, 0xc3, 0xbc}, {2, 0xc4, 0xb1}, {2, 0xc5, 0x9f}, {2, 0xc3, 0xbf},
+};
+
+static const uint8_t ISO88591TOUTF8[128][4] = {
+    {2, 0xc2, 0x80}, {2, 0xc2, 0x81}, {2, 0xc2, 0x82}, {2, 0xc2, 0x83},
+    {2, 0xc2, 0x84}, {2, 0xc2, 0x85}, {2, 0xc2, 0x86}, {2, 0xc2, 0x87},
+    {2, 0xc2, 0x88}, {2, 0xc2, 0x89}, {2, 0xc2, 0x8a}, {2, 0xc2, 0x8b},
+    {2, 0xc2, 0x8c}, {2, 0xc2, 0x8d}, {2, 0xc2, 0x8e}, {2, 0xc2, 0x8f},
+    {2, 0xc2, 0x90}, {2, 0xc2, 0x91}, {2, 0xc2, 0x92}, {2, 0xc2, 0x93},
+    {2, 0xc2, 0x94}, {2, 0xc2, 0x95}, {2, 0xc2, 0x96}, {2, 0xc2, 0x97},
+    {2, 0xc2, 0x98}, {2, 0xc2, 0x99}, {2, 0xc2, 0x9a}, {2, 0xc2, 0x9b},
+    {2, 0xc2, 0x9c}, {2, 0xc2, 0x9d}, {2, 0xc2, 0x9e}, {2, 0xc2, 0x9f},
+    {2, 0xc2, 0xa0}, {2, 0xc2, 0xa1}, {2, 0xc2, 0xa2}, {2, 0xc2, 0xa3},
+    {2, 0xc2, 0xa4}, {2, 0xc2, 0xa5}, {2, 0xc2, 0xa6}, {2, 0xc2, 0xa7},
+    {2, 0xc2, 0xa8}, {2, 0xc2, 0xa9}, {2, 0xc2, 0xaa}, {2, 0xc2, 0xab},
+    {2, 0xc2, 0xac}, {2, 0xc2, 0xad}, {2, 0xc2, 0xae}, {2, 0xc2, 0xaf},
+    {2, 0xc2, 0xb0}, {2, 0xc2, 0xb1}, {2, 0xc2, 0xb2}, {2, 0xc2, 0xb3},
+    {2, 0xc2, 0xb4}, {2, 0xc2, 0xb5}, {2, 0xc2, 0xb6}, {2, 0xc2, 0xb7},
+    {2, 0xc2, 0xb8}, {2, 0xc2, 0xb9}, {2, 0xc2, 0xba}, {2, 0xc2, 0xbb},
+    {2, 0xc2, 0xbc}, {2, 0xc2, 0xbd}, {2, 0xc2, 0xbe}, {2, 0xc2, 0xbf},
+    {2, 0xc3, 0x80}, {2, 0xc3, 0x81}, {2, 0xc3, 0x82}, {2, 0xc3, 0x83},
+    {2, 0xc3, 0x84}, {2, 0xc3, 0x85}, {2, 0xc3, 0x86}, {2, 0xc3, 0x87},
+    {2, 0xc3, 0x88}, {2, 0xc3, 0x89}, {2, 0xc3, 0x8a}, {2, 0xc3, 0x8b},
+    {2, 0xc3, 0x8c}, {2, 0xc3, 0x8d}, {2, 0xc3, 0x8e}, {2, 0xc3, 0x8f},
+    {2, 0xc3, 0x90}, {2, 0xc3, 0x91}, {2, 0xc3, 0x92}, {2, 0xc3, 0x93},
+    {2, 0xc3, 0x94}, {2, 0xc3, 0x95}, {2, 0xc3, 0x96}, {2, 0xc3, 0x97},
+    {2, 0xc3, 0x98}, {2, 0xc3, 0x99}, {2, 0xc3, 0x9a}, {2, 0xc3, 0x9b},
+    {2, 0xc3, 0x9c}, {2, 0xc3, 0x9d}, {2, 0xc3, 0x9e}, {2, 0xc3, 0x9f},
+    {2, 0xc3, 0xa0}, {2, 0xc3, 0xa1}, {2, 0xc3, 0xa2}, {2, 0xc3, 0xa3},
+    {2, 0xc3, 0xa4}, {2, 0xc3, 0xa5}, {2, 0xc3, 0xa6}, {2, 0xc3, 0xa7},
+    {2, 0xc3, 0xa8}, {2, 0xc3, 0xa9}, {2, 0xc3, 0xaa}, {2, 0xc3, 0xab},
+    {2, 0xc3, 0xac}, {2, 0xc3, 0xad}, {2, 0xc3, 0xae}, {2, 0xc3, 0xaf},
+    {2, 0xc3, 0xb0}, {2, 0xc3, 0xb1}, {2, 0xc3, 0xb2}, {2, 0xc3, 0xb3},
+    {2, 0xc3, 0xb4}, {2, 0xc3, 0xb5}, {2, 0xc3, 0xb6}, {2, 0xc3, 0xb7},
+    {2, 0xc3, 0xb8}, {2, 0xc3, 0xb9}, {2, 0xc3, 0xba}, {2, 0xc3, 0xbb},
+    {2, 0xc3, 0xbc}, {2, 0xc3, 0xbd}, {2, 0xc3, 0xbe}, {2, 0xc3, 0xbf},
+};
+
+static const uint8_t ISO885915TOUTF8[128][4] = {
+    {2, 0xc2, 0x80}, {2, 0xc2, 0x81}, {2, 0xc2, 0x82}, {2, 0xc2, 0x83},
+    {2, 0xc2, 0x84}, {2, 0xc2, 0x85}, {2, 0xc2, 0x86}, {2, 0xc2, 0x87},
+    {2, 0xc2, 0x88}, {2, 0xc2, 0x89}, {2, 0xc2, 0x8a}, {2, 0xc2, 0x8b},
+    {2, 0xc2, 0x8c}, {2, 0xc2, 0x8d}, {2, 0xc2, 0x8e}, {2, 0xc2, 0x8f},
+    {2, 0xc2, 0x90}, {2, 0xc2, 0x91}, {2, 0xc2, 0x92}, {2, 0xc2, 0x93},
+    {2, 0xc2, 0x94}, {2, 0xc2, 0x95}, {2, 0xc2, 0x96}, {2, 0xc2, 0x97},
+    {2, 0xc2, 0x98}, {2, 0xc2, 0x99}, {2, 0xc2, 0x9a}, {2, 0xc2, 0x9b},
+    {2, 0xc2, 0x9c}, {2, 0xc2, 0x9d}, {2, 0xc2, 0x9e}, {2, 0xc2, 0x9f},
+    {2, 0xc2, 0xa0}, {2, 0xc2, 0xa1}, {2, 0xc2, 0xa2}, {2, 0xc2, 0xa3},
+    {3, 0xe2, 0x82, 0xac}, {2, 0xc2, 0xa5}, {2, 0xc5, 0xa0}, {2, 0xc2, 0xa7},
+    {2, 0xc5, 0xa1}, {2, 0xc2, 0xa9}, {2, 0xc2, 0xaa}, {2, 0xc2, 0xab},
+    {2, 0xc2, 0xac}, {2, 0xc2, 0xad}, {2, 0xc2, 0xae}, {2, 0xc2, 0xaf},
+    {2, 0xc2, 0xb0}, {2, 0xc2, 0xb1}, {2, 0xc2, 0xb2}, {2, 0xc2, 0xb3},
+    {2, 0xc5, 0xbd}, {2, 0xc2, 0xb5}, {2, 0xc2, 0xb6}, {2, 0xc2, 0xb7},
+    {2, 0xc5, 0xbe}, {2, 0xc2, 0xb9}, {2, 0xc2, 0xba}, {2, 0xc2, 0xbb},
+    {2, 0xc5, 0x92}, {2, 0xc5, 0x93}, {2, 0xc5, 0xb8}, {2, 0xc2, 0xbf},
+    {2, 0xc3, 0x80}, {2, 0xc3, 0x81}, {2, 0xc3, 0x82}, {2, 0xc3, 0x83},
+    {2, 0xc3, 0x84}, {2, 0xc3, 0x85}, {2, 0xc3, 0x86}, {2, 0xc3, 0x87},
+    {2, 0xc3, 0x88}, {2, 0xc3, 0x89}, {2, 0xc3, 0x8a}, {2, 0xc3, 0x8b},
+    {2, 0xc3, 0x8c}, {2, 0xc3, 0x8d}, {2, 0xc3, 0x8e}, {2, 0xc3, 0x8f},
+    {2, 0xc3, 0x90}, {2, 0xc3, 0x91}, {2, 0xc3, 0x92}, {2, 0xc3, 0x93},
+    {2, 0xc3, 0x94}, {2, 0xc3, 0x95}, {2, 0xc3, 0x96}, {2, 0xc3, 0x97},
+    {2, 0xc3, 0x98}, {2, 0xc3, 0x99}, {2, 0xc3, 0x9a}, {2, 0xc3, 0x9b},
+    {2, 0xc3, 0x9c}, {2, 0xc3, 0x9d}, {2, 0xc3, 0x9e}, {2, 0xc3, 0x9f},
+    {2, 0xc3, 0xa0}, {2, 0xc3, 0xa1}, {2, 0xc3, 0xa2}, {2, 0xc3, 0xa3},
+    {2, 0xc3, 0xa4}, {2, 0xc3, 0xa5}, {2, 0xc3, 0xa6}, {2, 0xc3, 0xa7},
+    {2, 0xc3, 0xa8}, {2, 0xc3, 0xa9}, {2, 0xc3, 0xaa}, {2, 0xc3, 0xab},
+    {2, 0xc3, 0xac}, {2, 0xc3, 0xad}, {2, 0xc3, 0xae}, {2, 0xc3, 0xaf},
+    {2, 0xc3, 0xb0}, {2, 0xc3, 0xb1}, {2, 0xc3, 0xb2}, {2, 0xc3, 0xb3},
+    {2, 0xc3, 0xb4}, {2, 0xc3, 0xb5}, {2, 0xc3, 0xb6}, {2, 0xc3, 0xb7},
+    {2, 0xc3, 0xb8}, {2, 0xc3, 0xb9}, {2, 0xc3, 0xba}, {2, 0xc3, 0xbb},
+    {2, 0xc3, 0xbc}, {2, 0xc3, 0xbd}, {2, 0xc3, 0xbe}, {2, 0xc3, 0xbf},
+};
+
+static const CODEPAGE CODEPAGES[] = {
+    {"CP437", "IBM437 437", CP437TOUTF8},
+    {"CP850", "IBM850 850", CP850TOUTF8},
+    {"CP852", "IBM852 852", CP852TOUTF8},
+    {"CP865", "IBM865 865", CP865TOUTF8},
+    {"CP866", "IBM866 866", CP866TOUTF8},
+    {"CP1250", "WINDOWS1250", CP1250TOUTF8},
+    {"CP1251", "WINDOWS1251", CP1251TOUTF8},
+    {"CP1252", "WINDOWS1252", CP1252TOUTF8},
+    {"CP1253", "WINDOWS1253", CP1253TOUTF8},
+    {"CP1254", "WINDOWS1254", CP1254TOUTF8},
+    {"ISO88591", "LATIN1 L1", ISO88591TOUTF8},
+    {"ISO885915", "LATIN9", ISO885915TOUTF8},
+    {NULL, NULL, NULL}
+};
@@ -0,0 +1,59 @@
+#!/usr/bin/env python3
+
+"""Generate codepages.h, the tables PgDBF uses to convert common
+single-byte codepages to UTF-8 without calling iconv()"""
+
+import codecs
+import sys
+
+# (Python codec, PgDBF name, other names it's known by). Names are matched
+# case-insensitively and without any dashes or underscores.
+CODEPAGES = (
+    ('cp437', 'CP437', ('IBM437', '437')),
+    ('cp850', 'CP850', ('IBM850', '850')),
+    ('cp852', 'CP852', ('IBM852', '852')),
+    ('cp865', 'CP865', ('IBM865', '865')),
+    ('cp866', 'CP866', ('IBM866', '866')),
+    ('cp1250', 'CP1250', ('WINDOWS1250',)),
+    ('cp1251', 'CP1251', ('WINDOWS1251',)),
+    ('cp1252', 'CP1252', ('WINDOWS1252',)),
+    ('cp1253', 'CP1253', ('WINDOWS1253',)),
+    ('cp1254', 'CP1254', ('WINDOWS1254',)),
+    ('latin_1', 'ISO88591', ('LATIN1', 'L1')),
+    ('iso8859_15', 'ISO885915', ('LATIN9',)),
+)
+
+
+def utf8entry(codec, byte):
+    """Return the C initializer for one high byte of a codepage"""
+    try:
+        encoded = bytes([byte]).decode(codec).encode('utf-8')
+    except UnicodeDecodeError:
+        return '{0}'
+    assert len(encoded) <= 3
+    return '{%d, %s}' % (len(encoded), ', '.join('0x%02x' % c for c in encoded))
+
+
+def main():
+    out = sys.stdout
+    out.write('/* Generated by getcodepages.py. Do not edit. */\n\n')
+    out.write('/* Each table maps the bytes 0x80 through 0xFF of a codepage to UTF-8,\n'
+              ' * as a length followed by up to three bytes. A length of 0 means that\n'
+              ' * the codepage doesn\'t define that byte. The bytes below 0x80 are the\n'
+              ' * same as ASCII in all of these codepages. */\n')
+    for codec, name, _ in CODEPAGES:
+        for byte in range(128):
+            assert bytes([byte]).decode(codec) == chr(byte)
+        out.write('\nstatic const uint8_t %sTOUTF8[128][4] = {\n' % name)
+        entries = [utf8entry(codec, byte) for byte in range(128, 256)]
+        for i in range(0, 128, 4):
+            out.write('    %s,\n' % ', '.join(entries[i:i + 4]))
+        out.write('};\n')
+    out.write('\nstatic const CODEPAGE CODEPAGES[] = {\n')
+    for _, name, aliases in CODEPAGES:
+        out.write('    {"%s", "%s", %sTOUTF8},\n' % (name, ' '.join(aliases), name))
+    out.write('    {NULL, NULL, NULL}\n};\n')
+
+
+if __name__ == '__main__':
+    main()
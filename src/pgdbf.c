@@ -19,100 +19,399 @@
 #include <ctype.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <getopt.h>
 #include <inttypes.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <unistd.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 
 #include "pgdbf.h"
-#define STANDARDOPTS "cCdDeEhm:i:nNpPqQrRtTuU"
+#define STANDARDOPTS "cCdDeEhm:i:nNpPqQrRs:tTuU"
+
+/* getopt_long() returns these for options that only have long names */
+enum {
+    LONGOPTFLUSHSIZE = 256,
+    LONGOPTBINARY,
+    LONGOPTCONNECT,
+    LONGOPTDATAFILE,
+    LONGOPTNOMMAP,
+    LONGOPTBATCH,
+    LONGOPTBATCHJOBS,
+    LONGOPTOUTPUTDIR,
+    LONGOPTSTATS,
+    LONGOPTSTARTRECORD,
+    LONGOPTENDRECORD,
+    LONGOPTCHECKPOINT,
+    LONGOPTSHARDS,
+    LONGOPTOUTPUTPREFIX,
+    LONGOPTFINGERPRINTS,
+    LONGOPTCOMPRESS,
+    LONGOPTCOMPRESSLEVEL,
+    LONGOPTCOMPRESSTHREADS,
+    LONGOPTINCLUDE,
+    LONGOPTWHERE,
+    LONGOPTMAXMEMORY,
+    LONGOPTFASTLOAD,
+    LONGOPTUNLOGGED,
+    LONGOPTINDEXMEMORY,
+    LONGOPTINDEXWORKERS,
+    LONGOPTNARROWTYPES
+};
+
+static const struct option LONGOPTS[] = {
+    {"batch", no_argument, NULL, LONGOPTBATCH},
+    {"batch-jobs", required_argument, NULL, LONGOPTBATCHJOBS},
+    {"binary", no_argument, NULL, LONGOPTBINARY},
+    {"checkpoint", required_argument, NULL, LONGOPTCHECKPOINT},
+    {"compress", required_argument, NULL, LONGOPTCOMPRESS},
+    {"compress-level", required_argument, NULL, LONGOPTCOMPRESSLEVEL},
+    {"compress-threads", required_argument, NULL, LONGOPTCOMPRESSTHREADS},
+#if defined(HAVE_LIBPQ)
+    {"connect", required_argument, NULL, LONGOPTCONNECT},
+#endif
+    {"data-file", required_argument, NULL, LONGOPTDATAFILE},
+    {"end-record", required_argument, NULL, LONGOPTENDRECORD},
+    {"fast-load", no_argument, NULL, LONGOPTFASTLOAD},
+    {"fingerprints", required_argument, NULL, LONGOPTFINGERPRINTS},
+    {"flush-size", required_argument, NULL, LONGOPTFLUSHSIZE},
+    {"include", required_argument, NULL, LONGOPTINCLUDE},
+    {"index-memory", required_argument, NULL, LONGOPTINDEXMEMORY},
+    {"index-workers", required_argument, NULL, LONGOPTINDEXWORKERS},
+    {"max-memory", required_argument, NULL, LONGOPTMAXMEMORY},
+    {"narrow-types", no_argument, NULL, LONGOPTNARROWTYPES},
+    {"no-mmap", no_argument, NULL, LONGOPTNOMMAP},
+    {"output-dir", required_argument, NULL, LONGOPTOUTPUTDIR},
+    {"output-prefix", required_argument, NULL, LONGOPTOUTPUTPREFIX},
+    {"shards", required_argument, NULL, LONGOPTSHARDS},
+    {"start-record", required_argument, NULL, LONGOPTSTARTRECORD},
+    {"stats", no_argument, NULL, LONGOPTSTATS},
+    {"unlogged", no_argument, NULL, LONGOPTUNLOGGED},
+    {"where", required_argument, NULL, LONGOPTWHERE},
+    {NULL, 0, NULL, 0}
+};
+
+/* Command line options. main() sets these before any tables are converted,
+ * and they're only read after that. */
+static int         optnumericasnumeric = 1;
+static int         optshowprogress = 0;
+static int         optusecreatetable = 1;
+static int         optusedroptable = 1;
+static int         optuseifexists = 1;
+static int         optignorefields = 0;
+static int         optusequotedtablename = 0;
+static int         optusetransaction = 1;
+static int         optusetruncatetable = 0;
+static int         opttrimpadding = 1;
+static int         optjobs = 1;
+static size_t      optflushsize = OUTBUFFLUSHSIZE;
+static int         optbinary = 0;
+static char       *optdatafile = NULL;
+static char       *optconninfo = NULL;
+static int         optmmap = 1;
+static int         optbatch = 0;
+static int         optbatchjobs = 0;   /* 0 means one per processor */
+static char       *optoutputdir = NULL;
+static const char *optinputcharset = NULL;
+static int         optstats = 0;
+static size_t      optstartrecord = 0;
+static size_t      optendrecord = SIZE_MAX;
+static char       *optcheckpoint = NULL;
+static int         optshards = 0;
+static char       *optoutputprefix = NULL;
+static char       *optfingerprints = NULL;
+static int         optcompress = COMPRESSNONE;
+static int         optcompresslevel = 0;   /* 0 means the method's default */
+static int         optcompressthreads = 0;
+static char      **optwhere = NULL;
+static int         optwherecount = 0;
+static size_t      optmaxmemory = 0;       /* 0 means no limit */
+static size_t      tablememory = 0;        /* Each table's share of it */
+static int         optfastload = 0;
+static int         optunlogged = 0;
+static size_t      optindexmemory = FASTLOADINDEXMEMORY;
+static int         optindexworkers = FASTLOADINDEXWORKERS;
+static int         optnarrowtypes = 0;
+static IGNFIELD   *ignorefields;
+static int         ignorefieldcount = 0;
+static int         optincludefields = 0;
+static IGNFIELD   *includefields;
+static int         includefieldcount = 0;
+
+static IGNFIELD *splitfieldnames(char *list, int *count) {
+    /* Split a comma-separated list of field names, like the one given to
+     * -i, in place */
+    IGNFIELD *names;
+    char     *name;
+    int       i;
+
+    *count = 1;
+    for(i = 0; list[i] != '\0'; i++) {
+        if(list[i] == ',') {
+            (*count)++;
+        }
+    }
+    names = calloc(*count, sizeof(IGNFIELD));
+    if(names == NULL) {
+        exitwitherror("Unable to allocate the field name list", 1);
+    }
+    i = 0;
+    for(name = strtok(list, ","); name != NULL; name = strtok(NULL, ",")) {
+        names[i++].field = name;
+    }
+    *count = i;
+    return names;
+}
+
+static int openprefixfile(const char *suffix) {
+    /* Create the file named by --output-prefix plus suffix and return its
+     * descriptor */
+    char *filename;
+    int   fd;
+
+    if(asprintf(&filename, "%s.%s%s", optoutputprefix, suffix, COMPRESSSUFFIXES[optcompress]) < 0) {
+        exitwitherror("Unable to allocate an output filename", 1);
+    }
+    fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd == -1) {
+        fprintf(stderr, "Unable to open %s: %s\n", filename, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    free(filename);
+    return fd;
+}
+
+static void startoutput(OUTBUF *output, COMPRESSOR *compressor) {
+    /* Start compressing output's contents if --compress was given */
+    if(optcompress != COMPRESSNONE) {
+        compressoutbuf(output, compressor, optcompress, optcompresslevel, optcompressthreads);
+    }
+}
+
+static void endoutput(OUTBUF *output, COMPRESSOR *compressor) {
+    /* Write the rest of output's contents, ending the compressed stream if
+     * startoutput() began one */
+    if(optcompress != COMPRESSNONE) {
+        finishcompressor(output, compressor);
+    } else {
+        outbufflush(output);
+    }
+}
+
+static void *shardworker(void *arg) {
+    /* Write one shard's records to prefix.N.sql as a complete \COPY */
+    SHARD        *shard = (SHARD *) arg;
+    STATS        *stats = optstats ? &shard->stats : NULL;
+    DBFREADER     dbfreader;
+    FORMATTER     formatter;
+    MEMOPREFETCH  memoprefetch;
+    OUTBUF        output;
+    COMPRESSOR    compressor;
+    const char   *records;
+    size_t        blocksread;
+    uint64_t      started;
+    char          suffix[32];
+    int           fd;
+
+    /* Every shard opens the DBF file for itself so that shards reading it
+     * with fread() don't share a file position */
+    opendbfreader(&dbfreader, shard->dbffilename, optmmap);
+    startdbfreader(&dbfreader, shard->headerlength, shard->table->recordlength,
+                   shard->firstrecord, shard->recordcount, shard->batchsize);
+
+    sprintf(suffix, "%d.sql", shard->number);
+    fd = openprefixfile(suffix);
+    initoutbuf(&output, fd, optflushsize);
+    output.stats = stats;
+    startoutput(&output, &compressor);
+    initformatter(&formatter, &output, shard->longestfield, 0, shard->inputcharset, shard->memorylimit / MEMORYSHARES, stats);
+    memset(&memoprefetch, 0, sizeof(memoprefetch));
+    memoprefetch.window = shard->memorylimit / MEMORYSHARES;
+
+    outbufprintf(&output, "\\COPY %s FROM STDIN\n", shard->baretablename);
+    for(;;) {
+        started = statsclock(stats);
+        blocksread = readdbfbatch(&dbfreader, &records);
+        statsphase(stats, STATREAD, started);
+        if(!blocksread) {
+            break;
+        }
+        if(shard->table->memomap != NULL) {
+            started = statsclock(stats);
+            prefetchmemos(&memoprefetch, &formatter.arena, shard->table, records, blocksread);
+            statsphase(stats, STATMEMO, started);
+        }
+        started = statsclock(stats);
+        formatbatch(&output, &formatter, 1, shard->table, records, blocksread);
+        resetarena(&formatter.arena);
+        statsphase(stats, STATFORMAT, started);
+        if(stats != NULL) {
+            stats->bytesin += blocksread * shard->table->recordlength;
+        }
+    }
+    if(stats != NULL) {
+        stats->memosprefetched += memoprefetch.memocount;
+        stats->memoranges += memoprefetch.rangecount;
+    }
+    outbufprintf(&output, "\\.\n");
+    endoutput(&output, &compressor);
+
+    freeformatter(&formatter);
+    freedbfreader(&dbfreader);
+    closedbfreader(&dbfreader);
+    freeoutbuf(&output);
+    if(close(fd) == -1) {
+        exitwitherror("Unable to close a shard file", 1);
+    }
+    return NULL;
+}
+
+static void writeshards(const SHARD *table, const size_t firstrecord, const size_t lastrecord, STATS *stats) {
+    /* Split the records from firstrecord up to lastrecord into optshards
+     * contiguous ranges and write them all at once, each to its own file.
+     * table holds everything that the shards have in common. */
+    SHARD  *shards;
+    size_t  recordcount = lastrecord - firstrecord;
+    int     i;
+#if defined(HAVE_PTHREAD)
+    pthread_t threads[MAXJOBS];
+#endif
+
+    shards = malloc(optshards * sizeof(SHARD));
+    if(shards == NULL) {
+        exitwitherror("Unable to malloc the shards", 1);
+    }
+    for(i = 0; i < optshards; i++) {
+        shards[i] = *table;
+        shards[i].number = i;
+        shards[i].firstrecord = firstrecord + recordcount * i / optshards;
+        shards[i].recordcount = firstrecord + recordcount * (i + 1) / optshards - shards[i].firstrecord;
+    }
+#if defined(HAVE_PTHREAD)
+    for(i = 1; i < optshards; i++) {
+        if(pthread_create(&threads[i], NULL, shardworker, &shards[i])) {
+            exitwitherror("Unable to start a shard writer", 0);
+        }
+    }
+    shardworker(&shards[0]);
+    for(i = 1; i < optshards; i++) {
+        if(pthread_join(threads[i], NULL)) {
+            exitwitherror("Unable to join a shard writer", 0);
+        }
+    }
+#else
+    for(i = 0; i < optshards; i++) {
+        shardworker(&shards[i]);
+    }
+#endif
+    if(stats != NULL) {
+        for(i = 0; i < optshards; i++) {
+            addstats(stats, &shards[i].stats);
+        }
+    }
+    free(shards);
+}
+
+static void converttable(const char *dbffilename, const char *memofilename, OUTBUF *output, char **indexcolumns, const int indexcount) {
+    /* Convert one DBF file, writing the script to output or, with
+     * --connect, running it directly */
 
-int main(int argc, char **argv) {
     /* Describing the DBF file */
-    char          *dbffilename;
-    FILE          *dbffile;
+    DBFREADER      dbfreader;
     DBFHEADER      dbfheader;
     DBFFIELD      *fields;
     PGFIELD       *pgfields;
     size_t         dbffieldsize;
     size_t         fieldcount;     /* Number of fields for this DBF file */
-    unsigned int   recordbase;     /* The first record in a batch of records */
+    size_t         recordnumber;   /* The next record to convert */
+    size_t         firstrecord;    /* The range of records to convert */
+    size_t         lastrecord;
     unsigned int   dbfbatchsize;   /* How many DBF records to read at once */
-    unsigned int   batchindex;     /* The offset inside the current batch of
-                                    * DBF records */
+    size_t         memorylimit;    /* This conversion's share of
+                                    * --max-memory, or 0 */
+    size_t         memofieldcount;
     int            skipbytes;      /* The length of the Visual FoxPro DBC in
                                     * this file (if there is one) */
     int            fieldarraysize; /* The length of the field descriptor
                                     * array */
     int            fieldnum;       /* The current field beind processed */
     uint8_t        terminator;     /* Testing for terminator bytes */
+    int            visualfoxpro = 0;
 
     /* Describing the memo file */
     MEMOHEADER   *memoheader;
-    char         *memofilename = NULL;
     int          memofd;
     struct stat  memostat;
     int32_t      memoblocknumber;
     int          memofileisdbase3 = 0;
+    int          memomapisfile = 0;
 
     void        *memomap = NULL;     /* Pointer to the mmap of the memo file */
-    char        *memorecord;         /* Pointer to the current memo block */
     size_t       memoblocksize = 0;  /* The length of each memo block */
-    size_t       memofilesize;
-    size_t       memorecordoffset;
+    size_t       memofilesize = 0;
+    MEMOPREFETCH memoprefetch;
 
     /* Processing and misc */
-    IGNFIELD     *ignorefields;
-    char *istr;
-    char *inputbuffer;
-    char *outputbuffer;
-    char *bufoffset;
+    TABLEINFO     table;
+    FORMATTER    *formatters;
+    FIELDSTEP    *plan;
+    STATS        *stats = output->stats; /* NULL unless collecting stats */
+    STATS        *jobstats = NULL;
+    uint64_t      started;
+    OUTBUF        dataoutput;     /* Used when the data has its own file */
+    SHARD         shard;          /* What every shard has in common */
+    int           schemafd;
+    COMPRESSOR   *compressor;
+    OUTBUF       *copyoutput;     /* Where the COPY data goes */
+    int           datafd = -1;
+#if defined(HAVE_LIBPQ)
+    PGconn       *conn = NULL;      /* Set when loading directly */
+    char         *copycommand;
+#endif
+    const char *records;
+    int         resuming = 0;       /* Set when continuing from a checkpoint */
+    int         loaded = 0;         /* Set when the checkpoint's load finished */
+#if defined(HAVE_LIBPQ)
+    size_t      servernext;
+    int         serverfound;
+    int         serverloaded;
+#endif
+    FILE       *oldfingerprints = NULL;
+    int         delta = 0;          /* Set when only loading the changes */
+    FINGERPRINTS fingerprints;
+    FIELDSTEP  *keyplan = NULL;
+    char       *newfingerprints;
+    char       *deltatablename;
+    char       *gonetablename;
+    size_t      tablenamelength;
+    const char *copyoptions;        /* The WITH clause for the COPYs */
+    int         usecreatetable = optusecreatetable;
+    int         usedroptable = optusedroptable;
+    int         usetruncatetable = optusetruncatetable;
+    int         usefieldnames;      /* Set when fieldnames is needed */
+    FILTER     *filters = NULL;     /* From --where */
+    COLUMNSCAN *scans;              /* From --narrow-types */
+    size_t      scancount;
+    size_t      scanbatchsize;
+    struct stat dbfstat;
     char *s;
     char *t;
-    char *u;
     int     lastcharwasreplaced = 0;
-    int     printedfieldcount;
-    int     cnt = 1;
     int     i;
     int     j;
     int     isreservedname;
     int     printed;
     size_t  blocksread;
+    size_t  arenapeak;
     size_t  longestfield = 32;  /* Make sure we leave at least enough room
                                  * to print out long formatted numbers, like
                                  * currencies. */
 
-    /* Datetime calculation stuff */
-    int32_t juliandays;
-    int32_t seconds;
-    int     hours;
-    int     minutes;
-
-    /* Command line option parsing */
-    int     opt;
-    int     optexitcode = -1;   /* Left at -1 means that the arguments were
-                                 * valid and the program should run.
-                                 * Anything else is an exit code and the
-                                 * program will stop. */
-    char    optvalidargs[sizeof(STANDARDOPTS) + 3];
-
-    /* Default values for command line options */
-    int     optnumericasnumeric = 1;
-    int     optshowprogress = 0;
-    int     optusecreatetable = 1;
-    int     optusedroptable = 1;
-    int     optuseifexists = 1;
-    int     optignorefields = 0;
-    int     optusequotedtablename = 0;
-    int     optusetransaction = 1;
-    int     optusetruncatetable = 0;
-    int     opttrimpadding = 1;
-
     /* Describing the PostgreSQL table */
     char *tablename;
     char *baretablename;
@@ -121,249 +420,43 @@ int main(int argc, char **argv) {
     char basename[MAXCOLUMNNAMESIZE];
     int serial;
 
-#if defined(HAVE_ICONV)
     /* Character encoding stuff */
-    char *optinputcharset = NULL;
-#endif
-
-    strcpy(optvalidargs, STANDARDOPTS);
-#if defined(HAVE_ICONV)
-    /* Note that the declaration for optvalidargs currently reserves exactly
-     * three chars for this value (two for the string, one for the trailing
-     * \0). If you change this value, be sure to alter the optvalidargs
-     * declaration accordingly! */
-    strcat(optvalidargs, "s:");
-#endif
-
-    /* Attempt to parse any command line arguments */
-    while((opt = getopt(argc, argv, optvalidargs)) != -1) {
-        switch(opt) {
-        case 'c':
-            optusecreatetable = 1;
-            optusetruncatetable = 0;
-            break;
-        case 'C':
-            optusecreatetable = 0;
-            break;
-        case 'd':
-            optusedroptable = 1;
-            optusetruncatetable = 0;
-            break;
-        case 'D':
-            optusedroptable = 0;
-            break;
-        case 'e':
-            optuseifexists = 1;
-            break;
-        case 'E':
-            optuseifexists = 0;
-            break;
-        case 'i':
-            optignorefields = 1;
-            for (i = 0; optarg[i] != '\0'; i++){
-                if (optarg[i] == ',')
-                    cnt++;
-            }
-            ignorefields = calloc(cnt,sizeof(IGNFIELD));
-            istr = strtok(optarg,",");
-            i = 0;
-            while (istr != NULL)
-            {
-                ignorefields[i].field = istr;
-                istr = strtok(NULL,",");
-                i++;
-            }
-            break;
-        case 'm':
-            memofilename = optarg;
-            break;
-        case 'n':
-            optnumericasnumeric = 1;
-            break;
-        case 'N':
-            optnumericasnumeric = 0;
-            break;
-        case 'p':
-            optshowprogress = 1;
-            break;
-        case 'P':
-            optshowprogress = 0;
-            break;
-        case 'q':
-            optusequotedtablename = 1;
-            break;
-        case 'Q':
-            optusequotedtablename = 0;
-            break;
-        case 'r':
-            opttrimpadding = 1;
-            break;
-        case 'R':
-            opttrimpadding = 0;
-            break;
-#if defined(HAVE_ICONV)
-        case 's':
-            optinputcharset = optarg;
-            break;
-#endif
-        case 't':
-            optusetransaction = 1;
-            break;
-        case 'T':
-            optusetransaction = 0;
-            break;
-        case 'u':
-            optusetruncatetable = 1;
-            optusecreatetable = 0;
-            optusedroptable = 0;
-            break;
-        case 'U':
-            optusetruncatetable = 0;
-            break;
-        case 'h':
-        default:
-            /* If we got here because someone requested '-h', exit
-             * successfully.  Otherwise they used an invalid option, so
-             * fail. */
-            optexitcode = ((char) opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE);
-        }
-    }
-
-    /* Checking that the user specified a filename, unless we're already
-     * exiting for other reasons in which case it doesn't matter */
-    if(optexitcode != EXIT_SUCCESS && optind > (argc - 1)) {
-        optexitcode = EXIT_FAILURE;
-    }
-
-    if(optexitcode != -1) {
-        printf(
-#if defined(HAVE_ICONV)
-               "Usage: %s [-cCdDeEhtTuU] [-s encoding] [-m memofilename] [-i fieldname1,fieldname2,fieldnameN] filename [indexcolumn ...]\n"
-#else
-               "Usage: %s [-cCdDeEhtTuU] [-m memofilename] [-i fieldname1,fieldname2,fieldnameN] filename [indexcolumn ...]\n"
-#endif
-               "Convert the named XBase file into PostgreSQL format\n"
-               "\n"
-               "  -c  issue a 'CREATE TABLE' command to create the table (default)\n"
-               "  -C  do not issue a 'CREATE TABLE' command\n"
-               "  -d  issue a 'DROP TABLE' command before creating the table (default)\n"
-               "  -D  do not issue a 'DROP TABLE' command\n"
-               "  -e  use 'IF EXISTS' when dropping tables (PostgreSQL 8.2+) (default)\n"
-               "  -E  do not use 'IF EXISTS' when dropping tables (PostgreSQL 8.1 and older)\n"
-               "  -h  print this message and exit\n"
-               "  -i  ignore fields"
-               "  -m  the name of the associated memo file (if necessary)\n"
-               "  -n  use type 'NUMERIC' for NUMERIC fields (default)\n"
-               "  -N  use type 'TEXT' for NUMERIC fields\n"
-               "  -r  remove padding at the end of TEXT and VARCHAR fields (default)\n"
-               "  -R  keep padding at the end of TEXT and VARCHAR fields\n"
-               "  -p  show a progress bar during processing\n"
-               "  -P  do not show a progress bar\n"
-               "  -q  enclose the table name in quotation marks whenever used in statements\n"
-               "  -Q  do not enclose the table name in quotation marks (default)\n"
-#if defined(HAVE_ICONV)
-               "  -s  the encoding used in the file, to be converted to UTF-8\n"
-#endif
-               "  -t  wrap a transaction around the entire series of statements (default)\n"
-               "  -T  do not use an enclosing transaction\n"
-               "  -u  issue a 'TRUNCATE' command before inserting data\n"
-               "  -U  do not issue a 'TRUNCATE' command before inserting data (default)\n"
-               "\n"
-#if defined(HAVE_ICONV)
-               "If you don't specify an encoding via '-s', the data will be printed as is.\n"
-#endif
-               "Using '-u' implies '-C -D'. Using '-c' or '-d' implies '-U'.\n"
-               "\n"
-               "%s is copyright 2008-2012 kirk@strauser.com.\n"
-               "License GPLv3+: GNU GPL version 3 or later <http://gnu.org/licenses/gpl.html>\n"
-               "This is free software: you are free to change and redistribute it.\n"
-               "There is NO WARRANTY, to the extent permitted by law.\n"
-               "Report bugs to <%s>\n", PACKAGE, PACKAGE_STRING, PACKAGE_BUGREPORT);
-        exit(optexitcode);
-    }
-
-    /* Sanity check the arguments */
-    if(!optusecreatetable) {
-        /* It makes no sense to drop the table without creating it
-         * afterward */
-        optusedroptable = 0;
-    }
-
-#if defined(HAVE_ICONV)
-    /* Initialize iconv */
-    if(optinputcharset != NULL) {
-        const char *outputcharset = "UTF-8";
-        conv_desc = iconv_open(outputcharset, optinputcharset);
-
-        if(conv_desc == (iconv_t)-1) {
-            if(errno == EINVAL) {
-                fprintf(stderr, "Conversion from '%s' to '%s' is not supported.\n", optinputcharset, outputcharset);
-            } else {
-                fprintf(stderr, "Initialization failure: %s\n", strerror(errno));
-            }
-
-            exit(1);
-        }
-    }
-#endif
+    const char *inputcharset = optinputcharset;
 
-    /* Calculate the table's name based on the DBF filename */
-    dbffilename = argv[optind];
-    tablename = malloc(strlen(dbffilename) + 1);
-    if(tablename == NULL) {
-        exitwitherror("Unable to allocate the tablename buffer", 1);
-    }
-    /* The "bare" version of the tablename is the one used by itself in
-     * lines line CREATE TABLE [...], etc. Compare this with tablename which
-     * is used for other things, like creating the names of indexes. Despite
-     * its name, baretablename may be surrounded by quote marks if the "-q"
+    /* Calculate the table's name based on the DBF filename. The "bare"
+     * version of the tablename is the one used by itself in lines line
+     * CREATE TABLE [...], etc. Compare this with tablename which is used
+     * for other things, like creating the names of indexes. Despite its
+     * name, baretablename may be surrounded by quote marks if the "-q"
      * option for optusequotedtablename is given. */
-    baretablename = malloc(strlen(dbffilename) + 1 + optusequotedtablename * 2);
+    tablename = maketablename(dbffilename);
+    baretablename = malloc(strlen(tablename) + 1 + optusequotedtablename * 2);
     if(baretablename == NULL) {
         exitwitherror("Unable to allocate the bare tablename buffer", 1);
     }
-    /* Find the first character after the final slash, or the first
-     * character of the filename if no slash is present, and copy from that
-     * point to the period in the extension into the tablename string. */
-    for(s = dbffilename + strlen(dbffilename) - 1; s != dbffilename; s--) {
-        if(*s == '/') {
-            s++;
-            break;
-        }
-    }
-    /* Create tablename and baretablename at the same time. */
-    t = tablename;
-    u = baretablename;
-    if(optusequotedtablename) *u++ = '"';
-    while(*s) {
-        if(*s == '.') {
-            break;
-        }
-        *t = tolower(*s++);
-        *u++ = *t;
-        t++;
-    }
-    if(optusequotedtablename) *u++ = '"';
-    *t = '\0';
-    *u = '\0';
+    sprintf(baretablename, optusequotedtablename ? "\"%s\"" : "%s", tablename);
 
     /* Get the DBF header */
-    dbffile = fopen(dbffilename, "rb");
-    if(dbffile == NULL) {
-        exitwitherror("Unable to open the DBF file", 1);
-    }
-    if(setvbuf(dbffile, NULL, _IOFBF, DBFBATCHTARGET)) {
-        exitwitherror("Unable to set the buffer for the dbf file", 1);
-    }
-    if(fread(&dbfheader, sizeof(dbfheader), 1, dbffile) != 1) {
+    started = statsclock(stats);
+    opendbfreader(&dbfreader, dbffilename, optmmap);
+    if(!readdbfheader(&dbfreader, &dbfheader, sizeof(dbfheader))) {
         exitwitherror("Unable to read the entire DBF header", 1);
     }
 
+    /* Look up the file's codepage if asked to */
+    if(inputcharset != NULL && !strcasecmp(inputcharset, "auto")) {
+        inputcharset = codepageforlanguage((uint8_t) dbfheader.language);
+        if(inputcharset == NULL && dbfheader.language) {
+            fprintf(stderr, "Unknown language byte 0x%02X; the data will be printed as is\n", (uint8_t) dbfheader.language);
+        }
+    }
+
     if((dbfheader.signature == 0x30) || (dbfheader.signature == 0x31) || (dbfheader.signature == 0x32)) {
         /* Certain DBF files have an (empty?) 263-byte buffer after the header
          * information.  Take that into account when calculating field counts
          * and possibly seeking over it later. */
         skipbytes = 263;
+        visualfoxpro = 1;
     } else {
         skipbytes = 0;
     }
@@ -388,21 +481,17 @@ int main(int argc, char **argv) {
     if(fields == NULL) {
         exitwitherror("Unable to malloc the field descriptions", 1);
     }
-    if(fread(fields, dbffieldsize, fieldcount, dbffile) != fieldcount) {
+    if(!readdbfheader(&dbfreader, fields, fieldarraysize)) {
         exitwitherror("Unable to read all of the field descriptions", 1);
     }
 
     /* Keep track of PostgreSQL output parameters */
-    pgfields = malloc(fieldcount * sizeof(PGFIELD));
+    pgfields = calloc(fieldcount ? fieldcount : 1, sizeof(PGFIELD));
     if(pgfields == NULL) {
         exitwitherror("Unable to malloc the output parameter list", 1);
     }
-    for(i = 0; i < fieldcount; i++) {
-        pgfields[i].formatstring = NULL;
-    }
-
     /* Check for the terminator character */
-    if(fread(&terminator, 1, 1, dbffile) != 1) {
+    if(!readdbfheader(&dbfreader, &terminator, 1)) {
         exitwitherror("Unable to read the terminator byte", 1);
     }
     if(terminator != 13) {
@@ -410,12 +499,12 @@ int main(int argc, char **argv) {
     }
 
     /* Skip the database container if necessary */
-    if(fseek(dbffile, skipbytes, SEEK_CUR)) {
-        exitwitherror("Unable to seek in the DBF file", 1);
+    if(!readdbfheader(&dbfreader, NULL, skipbytes)) {
+        exitwitherror("Unable to read past the database container", 1);
     }
 
     /* Make sure we're at the right spot before continuing */
-    if(ftell(dbffile) != littleint16_t(dbfheader.headerlength)) {
+    if(dbfreader.position != littleint16_t(dbfheader.headerlength)) {
         exitwitherror("At an unexpected offset in the DBF file", 0);
     }
 
@@ -428,10 +517,19 @@ int main(int argc, char **argv) {
         if(fstat(memofd, &memostat) == -1) {
             exitwitherror("Unable to fstat the memofile", 1);
         }
-        memofilesize = memostat.st_size;
-        memomap = mmap(NULL, memofilesize, PROT_READ, MAP_PRIVATE, memofd, 0);
-        if(memomap == MAP_FAILED) {
-            exitwitherror("Unable to mmap the memofile", 1);
+        if(S_ISREG(memostat.st_mode) && compressionmethod(memofilename) == COMPRESSNONE) {
+            memofilesize = memostat.st_size;
+            memomap = mmap(NULL, memofilesize, PROT_READ, MAP_PRIVATE, memofd, 0);
+            if(memomap == MAP_FAILED) {
+                exitwitherror("Unable to mmap the memofile", 1);
+            }
+            memomapisfile = 1;
+        } else {
+            /* Compressed memo files and pipes are read into memory */
+            memomap = readintomap(memofd, compressionmethod(memofilename), &memofilesize, tablememory / MEMORYSHARES);
+        }
+        if(memofilesize < sizeof(MEMOHEADER)) {
+            exitwitherror("The memofile is too short to have a header", 0);
         }
         /* Rudimentary error checking. Make sure the "nextblock" field of
            the memofile's header isn't negative because that would be
@@ -453,27 +551,88 @@ int main(int argc, char **argv) {
             memoblocksize = (size_t) sbigint16_t(memoheader->blocksize);
         }
     }
+    statsphase(stats, STATHEADER, started);
+    if(stats != NULL) {
+        stats->tables++;
+        stats->bytesin += littleint16_t(dbfheader.headerlength);
+    }
+
+#if defined(HAVE_LIBPQ)
+    if(optconninfo != NULL) {
+        conn = connecttodatabase(optconninfo);
+    }
+#endif
+
+    /* Work out which records to convert. If an earlier run left a
+     * checkpoint, the server already committed the table and the records
+     * before the one the checkpoint names, so carry on from there. The
+     * server's own record of that is committed along with each batch, so
+     * it's trusted over the file, which is only written afterward. */
+    lastrecord = littleint32_t(dbfheader.recordcount);
+    if(optendrecord < lastrecord) {
+        lastrecord = optendrecord;
+    }
+    firstrecord = optstartrecord;
+    if(optcheckpoint != NULL) {
+        recordnumber = readcheckpoint(optcheckpoint, tablename, littleint16_t(dbfheader.recordlength), &resuming, &loaded);
+#if defined(HAVE_LIBPQ)
+        if(resuming) {
+            servernext = readserverprogress(conn, tablename, &serverfound, &serverloaded);
+            if(serverfound) {
+                recordnumber = servernext;
+                loaded = serverloaded;
+            }
+        }
+#endif
+        if(recordnumber > firstrecord) {
+            firstrecord = recordnumber;
+        }
+    }
+    if(firstrecord > lastrecord) {
+        firstrecord = lastrecord;
+    }
+
+    /* With fingerprints from an earlier run, only the changes since then
+     * are loaded into the existing table */
+    if(optfingerprints != NULL) {
+        oldfingerprints = fopen(optfingerprints, "rb");
+        if(oldfingerprints == NULL && errno != ENOENT) {
+            exitwitherror("Unable to open the fingerprint file", 1);
+        }
+        delta = oldfingerprints != NULL;
+    }
+    if(resuming || delta) {
+        usecreatetable = 0;
+        usedroptable = 0;
+        usetruncatetable = 0;
+    }
 
     /* Encapsulate the whole process in a transaction */
-    if(optusetransaction) {
-        printf("BEGIN;\n");
+    if(optusetransaction && !loaded) {
+        outbufprintf(output, "BEGIN;\n");
+    }
+    if(optcheckpoint != NULL && !loaded) {
+        outbufprintf(output, "CREATE TABLE IF NOT EXISTS %s (tablename TEXT PRIMARY KEY, "
+                     "nextrecord BIGINT NOT NULL, finished BOOLEAN NOT NULL);\n", CHECKPOINTTABLE);
     }
 
     /* Drop the table if requested */
-    if(optusedroptable) {
-        printf("SET statement_timeout=60000; DROP TABLE");
+    if(usedroptable) {
+        outbufprintf(output, "SET statement_timeout=60000; DROP TABLE");
         /* Newer versions of PostgreSQL (8.2+) support "if exists" when
          * dropping tables. */
         if(optuseifexists) {
-            printf(" IF EXISTS");
+            outbufprintf(output, " IF EXISTS");
         }
-        printf(" %s; SET statement_timeout=0;\n", baretablename);
+        outbufprintf(output, " %s; SET statement_timeout=0;\n", baretablename);
     }
 
     /* Uniqify the XBase field names. It's possible to have multiple fields
      * with the same name, but PostgreSQL correctly considers that an error
-     * condition. */
-    if(optusecreatetable) {
+     * condition. -i, --include, --where, and the fingerprint keys match
+     * against these names too. */
+    usefieldnames = usecreatetable || optignorefields || optincludefields || optwherecount || optfingerprints != NULL;
+    if(usefieldnames) {
         fieldnames = calloc(fieldcount, MAXCOLUMNNAMESIZE);
         if(fieldnames == NULL) {
             exitwitherror("Unable to allocate the columnname uniqification buffer", 1);
@@ -525,86 +684,156 @@ int main(int argc, char **argv) {
         }
     }
 
-    /* Generate the create table statement, do some sanity testing, and scan
-     * for a few additional output parameters.  This is an ugly loop that
-     * does lots of stuff, but extracting it into two or more loops with the
-     * same structure and the same switch-case block seemed even worse. */
-    if(optusecreatetable) printf("CREATE TABLE %s (", baretablename);
-    printed = 0;
-    for(fieldnum = 0; fieldnum < fieldcount; fieldnum++) {
-        if(optignorefields){
-            for (i = 0; i<cnt; ++i){
-                //printf("%s\n", ignorefields[i].field);
-                if(strcmp(fieldnames[fieldnum],ignorefields[i].field) == 0)
-                    fields[fieldnum].type = IGNORETYPE;
+    /* The --where conditions are compiled before -i and --include hide any
+     * of the fields they test */
+    if(optwherecount) {
+        filters = malloc(optwherecount * sizeof(FILTER));
+        if(filters == NULL) {
+            exitwitherror("Unable to malloc the filters", 1);
+        }
+        for(i = 0; i < optwherecount; i++) {
+            compilefilter(&filters[i], optwhere[i], fields, fieldnames, fieldcount);
+        }
+    }
+    for(i = 0; i < includefieldcount; i++) {
+        for(fieldnum = 0; fieldnum < fieldcount; fieldnum++) {
+            if(!strcasecmp(fieldnames[fieldnum], includefields[i].field)) {
+                break;
+            }
+        }
+        if(fieldnum == fieldcount) {
+            fprintf(stderr, "The table has no field named %s\n", includefields[i].field);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    /* Hide the fields that -i and --include leave out */
+    for(fieldnum = 0; fieldnum < fieldcount; fieldnum++) {
+        if(optignorefields){
+            for (i = 0; i<ignorefieldcount; ++i){
+                //printf("%s\n", ignorefields[i].field);
+                if(strcmp(fieldnames[fieldnum],ignorefields[i].field) == 0)
+                    fields[fieldnum].type = IGNORETYPE;
             }
         } 
+        if(optincludefields) {
+            /* Only the listed fields are decoded */
+            for(i = 0; i < includefieldcount; i++) {
+                if(!strcasecmp(fieldnames[fieldnum], includefields[i].field)) {
+                    break;
+                }
+            }
+            if(i == includefieldcount) {
+                fields[fieldnum].type = IGNORETYPE;
+            }
+        }
+    }
 
+    table.recordlength = littleint16_t(dbfheader.recordlength);
+    table.filters = filters;
+    table.filtercount = optwherecount;
+
+    /* With --narrow-types, read the records that will be loaded once
+     * before creating the table to find the narrowest types that hold all
+     * of their values. Only the raw bytes are looked at. */
+    if(optnarrowtypes && usecreatetable) {
+        if(fstat(fileno(dbfreader.file), &dbfstat) == -1 || !S_ISREG(dbfstat.st_mode)) {
+            exitwitherror("--narrow-types needs an uncompressed DBF file, not a pipe", 0);
+        }
+        started = statsclock(stats);
+        scans = plancolumnscans(fields, fieldcount, optnumericasnumeric, opttrimpadding, optjobs, &scancount);
+        scanbatchsize = tablememory && tablememory / MEMORYSHARES < DBFBATCHTARGET ? tablememory / MEMORYSHARES : DBFBATCHTARGET;
+        scanbatchsize /= table.recordlength;
+        startdbfreader(&dbfreader, littleint16_t(dbfheader.headerlength), table.recordlength,
+                       firstrecord, lastrecord - firstrecord, scanbatchsize ? scanbatchsize : 1);
+        while((blocksread = readdbfbatch(&dbfreader, &records))) {
+            scanbatch(scans, scancount, optjobs, &table, records, blocksread);
+        }
+        narrowfields(pgfields, scans, scancount, optjobs);
+        free(scans);
+        statsphase(stats, STATREAD, started);
+    }
+
+    /* Generate the create table statement, do some sanity testing, and scan
+     * for a few additional output parameters.  This is an ugly loop that
+     * does lots of stuff, but extracting it into two or more loops with the
+     * same structure and the same switch-case block seemed even worse. */
+    if(usecreatetable) outbufprintf(output, "CREATE %sTABLE %s (", optunlogged ? "UNLOGGED " : "", baretablename);
+    printed = 0;
+    for(fieldnum = 0; fieldnum < fieldcount; fieldnum++) {
         if(fields[fieldnum].type == '0' || fields[fieldnum].type == IGNORETYPE) {
             continue;
         }
-        if(printed && optusecreatetable) {
-            if(optusecreatetable) printf(", ");
+        if(printed && usecreatetable) {
+            if(usecreatetable) outbufprintf(output, ", ");
         }
         else {
             printed = 1;
         }
 
-        if(optusecreatetable) {
+        if(usecreatetable) {
             /* If the fieldname is a reserved word, rename it to start with
              * "tablename_" */
             isreservedname = 0;
             for(i = 0; RESERVEDWORDS[i]; i++ ) {
                 if(!strcmp(fieldnames[fieldnum], RESERVEDWORDS[i])) {
-                    printf("%s_%s ", tablename, fieldnames[fieldnum]);
+                    outbufprintf(output, "%s_%s ", tablename, fieldnames[fieldnum]);
                     isreservedname = 1;
                     break;
                 }
             }
-            if(!isreservedname) printf("%s ", fieldnames[fieldnum]);
+            if(!isreservedname) outbufprintf(output, "%s ", fieldnames[fieldnum]);
         }
 
         switch(fields[fieldnum].type) {
         case 'B':
-            /* Precalculate this field's format string so that it doesn't
-             * have to be done inside the main loop */
-            if(asprintf(&pgfields[fieldnum].formatstring, "%%.%dlf", fields[fieldnum].decimals) < 0) {
-                exitwitherror("Unable to allocate a format string", 1);
-            }
-            if(optusecreatetable) printf("DOUBLE PRECISION");
+            if(usecreatetable) outbufprintf(output, "DOUBLE PRECISION");
             break;
         case 'C':
         case 'V':
         case 'W':
-            if(optusecreatetable) printf("VARCHAR(%d)", fields[fieldnum].length);
+            if(usecreatetable) {
+                if(pgfields[fieldnum].varcharlength) {
+                    outbufprintf(output, "VARCHAR(%lu)", (unsigned long) pgfields[fieldnum].varcharlength);
+                } else {
+                    outbufprintf(output, "VARCHAR(%d)", fields[fieldnum].length);
+                }
+            }
             break;
         case 'D':
-            if(optusecreatetable) printf("DATE");
+            if(usecreatetable) outbufprintf(output, "DATE");
             break;
         case 'F':
-            if(fields[fieldnum].decimals > 0) {
-                printf("NUMERIC(%d, %d)", fields[fieldnum].length, fields[fieldnum].decimals);
-            } else {
-                printf("NUMERIC(%d)", fields[fieldnum].length);
+            if(usecreatetable) {
+                if(pgfields[fieldnum].integerwidth) {
+                    outbufprintf(output, "%s", integertypename(pgfields[fieldnum].integerwidth));
+                } else if(fields[fieldnum].decimals > 0) {
+                    outbufprintf(output, "NUMERIC(%d, %d)", fields[fieldnum].length, fields[fieldnum].decimals);
+                } else {
+                    outbufprintf(output, "NUMERIC(%d)", fields[fieldnum].length);
+                }
             }
             break;
-        case 'G':
-            if(optusecreatetable) printf("BYTEA");
-            break;
         case 'I':
-            if(optusecreatetable) printf("INTEGER");
+            if(usecreatetable) outbufprintf(output, "INTEGER");
             break;
         case 'L':
             /* This was a smallint at some point in the past */
-            if(optusecreatetable) printf("BOOLEAN");
+            if(usecreatetable) outbufprintf(output, "BOOLEAN");
             break;
+        case 'G':
         case 'M':
+        case 'P':
             if(memofilename == NULL) {
-                printf("\n");
+                outbufprintf(output, "\n");
                 fprintf(stderr, "Table %s has memo fields, but couldn't open the related memo file\n", tablename);
                 exit(EXIT_FAILURE);
             }
-            if(optusecreatetable) printf("TEXT");
+            /* General fields, pictures, and Visual FoxPro memos flagged as
+             * binary keep their bytes exactly as they are */
+            pgfields[fieldnum].bytea = fields[fieldnum].type != 'M' ||
+                                       (visualfoxpro && (littleint16_t(fields[fieldnum].flags) & BINARYFIELDFLAG));
+            if(usecreatetable) outbufprintf(output, pgfields[fieldnum].bytea ? "BYTEA" : "TEXT");
             /* Decide whether to use numeric or packed int memo block
              * number */
             if(fields[fieldnum].length == 4) {
@@ -616,26 +845,28 @@ int main(int argc, char **argv) {
             }
             break;
         case 'N':
-            if(optusecreatetable) {
-                if(optnumericasnumeric) {
+            if(usecreatetable) {
+                if(pgfields[fieldnum].integerwidth) {
+                    outbufprintf(output, "%s", integertypename(pgfields[fieldnum].integerwidth));
+                } else if(optnumericasnumeric) {
                     if(fields[fieldnum].decimals > 0) {
-                        printf("NUMERIC(%d, %d)", fields[fieldnum].length, fields[fieldnum].decimals);
+                        outbufprintf(output, "NUMERIC(%d, %d)", fields[fieldnum].length, fields[fieldnum].decimals);
                     } else {
-                        printf("NUMERIC(%d)", fields[fieldnum].length);
+                        outbufprintf(output, "NUMERIC(%d)", fields[fieldnum].length);
                     }
                 } else {
-                    printf("TEXT");
+                    outbufprintf(output, "TEXT");
                 }
             }
             break;
         case 'T':
-            if(optusecreatetable) printf("TIMESTAMP");
+            if(usecreatetable) outbufprintf(output, "TIMESTAMP");
             break;
         case 'Y':
-            if(optusecreatetable) printf("DECIMAL(20,4)");
+            if(usecreatetable) outbufprintf(output, "DECIMAL(20,4)");
             break;
         default:
-            if(optusecreatetable) printf("\n");
+            if(usecreatetable) outbufprintf(output, "\n");
             fprintf(stderr, "Unhandled field type: %c\n", fields[fieldnum].type);
             exit(EXIT_FAILURE);
         }
@@ -643,250 +874,1062 @@ int main(int argc, char **argv) {
             longestfield = fields[fieldnum].length;
         }
     }
-    if(optusecreatetable) printf(");\n");
+    if(usecreatetable) outbufprintf(output, ");\n");
 
     /* Truncate the table if requested */
-    if(optusetruncatetable) {
-        printf("TRUNCATE TABLE %s;\n", baretablename);
+    if(usetruncatetable) {
+        outbufprintf(output, "TRUNCATE TABLE %s;\n", baretablename);
     }
 
-    /* Get PostgreSQL ready to receive lots of input */
-    printf("\\COPY %s FROM STDIN\n", baretablename);
+    /* A table that was created or truncated in this transaction can be
+     * loaded with its rows already frozen, so that VACUUM doesn't have to
+     * rewrite every page of it later */
+    if(optfastload) {
+        copyoptions = optbinary ? " WITH (FORMAT binary, FREEZE)" : " WITH (FREEZE)";
+    } else {
+        copyoptions = optbinary ? " WITH (FORMAT binary)" : "";
+    }
 
-    dbfbatchsize = DBFBATCHTARGET / littleint16_t(dbfheader.recordlength);
-    if(!dbfbatchsize) {
-        dbfbatchsize = 1;
+    /* Describe the table to the record formatters */
+    table.plan = plan = compileplan(fields, pgfields, fieldcount, optbinary, &table.plansize);
+    table.memomap = memomap;
+    table.memoblocksize = memoblocksize;
+    table.memofilesize = memofilesize;
+    table.memofileisdbase3 = memofileisdbase3;
+    table.memomapisfile = memomapisfile;
+    table.trimpadding = opttrimpadding;
+    table.numericasnumeric = optnumericasnumeric;
+    table.binary = optbinary;
+
+    /* With --max-memory, each shard gets an equal share of the table's
+     * budget, and a batch of records can use part of that share. The list
+     * of memos prefetched for a batch also has to fit in half of the first
+     * formatter's scratch memory. */
+    memorylimit = optshards ? tablememory / optshards : tablememory;
+    if(memorylimit && memorylimit / MEMORYSHARES < DBFBATCHTARGET) {
+        dbfbatchsize = memorylimit / MEMORYSHARES / table.recordlength;
+    } else {
+        dbfbatchsize = DBFBATCHTARGET / table.recordlength;
     }
-    inputbuffer = malloc(littleint16_t(dbfheader.recordlength) * dbfbatchsize);
-    if(inputbuffer == NULL) {
-        exitwitherror("Unable to malloc a record buffer", 1);
+    memofieldcount = 0;
+    for(i = 0; (size_t) i < table.plansize; i++) {
+        memofieldcount += ismemotype(plan[i].type);
     }
-    outputbuffer = malloc(longestfield + 1);
-    if(outputbuffer == NULL) {
-        exitwitherror("Unable to malloc the output buffer", 1);
+    if(memorylimit && memofieldcount &&
+       dbfbatchsize > memorylimit / MEMORYSHARES / optjobs / 2 / (memofieldcount * sizeof(size_t))) {
+        dbfbatchsize = memorylimit / MEMORYSHARES / optjobs / 2 / (memofieldcount * sizeof(size_t));
+    }
+    if(!dbfbatchsize) {
+        dbfbatchsize = 1;
     }
 
-    /* Loop across records in the file, taking 'dbfbatchsize' at a time, and
-     * output them in PostgreSQL-compatible format */
-    if(optshowprogress) {
-        fprintf(stderr, "Progress: 0");
-        fflush(stderr);
+    /* Find the key columns, which identify the rows that a delta replaces
+     * or deletes */
+    if(optfingerprints != NULL) {
+        keyplan = malloc(indexcount * sizeof(FIELDSTEP));
+        if(keyplan == NULL) {
+            exitwitherror("Unable to malloc the key plan", 1);
+        }
+        tablenamelength = strlen(tablename);
+        for(i = 0; i < indexcount; i++) {
+            for(fieldnum = 0; fieldnum < fieldcount; fieldnum++) {
+                if(!strcmp(indexcolumns[i], fieldnames[fieldnum]) ||
+                   (!strncmp(indexcolumns[i], tablename, tablenamelength) && indexcolumns[i][tablenamelength] == '_' &&
+                    !strcmp(indexcolumns[i] + tablenamelength + 1, fieldnames[fieldnum]))) {
+                    break;
+                }
+            }
+            for(j = 0; fieldnum < fieldcount && j < table.plansize; j++) {
+                if(plan[j].pgfield == &pgfields[fieldnum]) {
+                    break;
+                }
+            }
+            if(fieldnum == fieldcount || j == table.plansize) {
+                fprintf(stderr, "Key column %s isn't in table %s\n", indexcolumns[i], tablename);
+                exit(EXIT_FAILURE);
+            }
+            if(ismemotype(plan[j].type)) {
+                fprintf(stderr, "Memo column %s can't be used as a key\n", indexcolumns[i]);
+                exit(EXIT_FAILURE);
+            }
+            keyplan[i] = plan[j];
+            keyplan[i].separator = i ? '\t' : '\0';
+        }
+        if(asprintf(&newfingerprints, "%s.new", optfingerprints) < 0 ||
+           asprintf(&deltatablename, optusequotedtablename ? "\"%s_delta\"" : "%s_delta", tablename) < 0 ||
+           asprintf(&gonetablename, optusequotedtablename ? "\"%s_gone\"" : "%s_gone", tablename) < 0) {
+            exitwitherror("Unable to allocate the fingerprint names", 1);
+        }
+        initfingerprints(&fingerprints, oldfingerprints, newfingerprints, &table, keyplan, indexcount,
+                         longestfield, inputcharset);
+        free(newfingerprints);
     }
-    for(recordbase = 0; recordbase < littleint32_t(dbfheader.recordcount); recordbase += dbfbatchsize) {
-        blocksread = fread(inputbuffer, littleint16_t(dbfheader.recordlength), dbfbatchsize, dbffile);
-        if(blocksread != dbfbatchsize &&
-           recordbase + blocksread < littleint32_t(dbfheader.recordcount)) {
-            exitwitherror("Unable to read an entire record", 1);
+
+    if(loaded) {
+        /* An earlier run with this checkpoint loaded every record and
+         * built the indexes, so there's nothing left to do */
+        fprintf(stderr, "The checkpoint says that %s is already loaded\n", tablename);
+        freedbfreader(&dbfreader);
+        free(plan);
+    } else if(optshards) {
+        /* The setup script ends here. The shards each load a range of the
+         * records, and the indexes go in a script of their own to be run
+         * once every shard has been loaded. */
+        if(optusetransaction) {
+            outbufprintf(output, "COMMIT;\n");
         }
-        for(batchindex = 0; batchindex < blocksread; batchindex++) {
-            bufoffset = inputbuffer + littleint16_t(dbfheader.recordlength) * batchindex;
-            /* Skip deleted records */
-            if(bufoffset[0] == '*') {
-                continue;
+        memset(&shard, 0, sizeof(shard));
+        shard.dbffilename = dbffilename;
+        shard.baretablename = baretablename;
+        shard.table = &table;
+        shard.headerlength = littleint16_t(dbfheader.headerlength);
+        shard.batchsize = dbfbatchsize;
+        shard.longestfield = longestfield;
+        shard.inputcharset = inputcharset;
+        shard.memorylimit = memorylimit;
+        writeshards(&shard, firstrecord, lastrecord, stats);
+        freedbfreader(&dbfreader);
+        free(plan);
+        /* A compressed schema file ends its stream before the indexes
+         * start a new one in the post-load file */
+        schemafd = output->fd;
+        compressor = output->sinkarg;
+        endoutput(output, compressor);
+        retargetoutbuf(output, openprefixfile("post.sql"));
+        startoutput(output, compressor);
+        if(close(schemafd) == -1) {
+            exitwitherror("Unable to close the schema file", 1);
+        }
+    } else {
+        /* Decide where the COPY data goes */
+#if defined(HAVE_LIBPQ)
+        if(conn != NULL) {
+            if(asprintf(&copycommand, "COPY %s FROM STDIN%s", baretablename, copyoptions) < 0) {
+                exitwitherror("Unable to allocate the COPY command", 1);
             }
-            bufoffset++;
+            initoutbuf(&dataoutput, -1, optflushsize);
+            dataoutput.stats = stats;
+            copyoutput = &dataoutput;
+        } else
+#endif
+        if(optdatafile == NULL) {
+            copyoutput = output;
+        } else {
+            datafd = open(optdatafile, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if(datafd == -1) {
+                exitwitherror("Unable to open the data file", 1);
+            }
+            initoutbuf(&dataoutput, datafd, optflushsize);
+            dataoutput.stats = stats;
+            copyoutput = &dataoutput;
+        }
 
-            printedfieldcount = 0;
-            for(fieldnum = 0; fieldnum < fieldcount; fieldnum++) {
-                if(fields[fieldnum].type == '0') {
-                    continue;
-                }
+        startdbfreader(&dbfreader, littleint16_t(dbfheader.headerlength), littleint16_t(dbfheader.recordlength),
+                       firstrecord, lastrecord - firstrecord, dbfbatchsize);
 
-                if(fields[fieldnum].type == IGNORETYPE) {
-                    bufoffset += fields[fieldnum].length;
-                    continue;
-                }
+        /* A single formatter writes straight to stdout. Otherwise, each
+         * worker collects its share of every batch in memory. */
+        formatters = malloc(optjobs * sizeof(FORMATTER));
+        if(formatters == NULL) {
+            exitwitherror("Unable to malloc the record formatters", 1);
+        }
+        if(stats != NULL && optjobs > 1) {
+            jobstats = calloc(optjobs, sizeof(STATS));
+            if(jobstats == NULL) {
+                exitwitherror("Unable to malloc the worker stats", 1);
+            }
+        }
+        for(i = 0; i < optjobs; i++) {
+            initformatter(&formatters[i], optjobs == 1 ? copyoutput : NULL, longestfield, optbinary, inputcharset,
+                          memorylimit / MEMORYSHARES / optjobs, jobstats != NULL ? &jobstats[i] : stats);
+        }
 
-                if(printedfieldcount)
-                    printf("\t");
+        if(optshowprogress && !optbatch) {
+            fprintf(stderr, "Progress: 0");
+            fflush(stderr);
+        }
+        memset(&memoprefetch, 0, sizeof(memoprefetch));
+        memoprefetch.window = memorylimit / MEMORYSHARES;
 
-                switch(fields[fieldnum].type) {
-                case 'B':
-                    /* Double floats */
-                    printf(pgfields[fieldnum].formatstring, sdouble(bufoffset));
-                    break;
-                case 'C':
-                case 'W':
-                    /* Varchars */
-                    safeprintbuf(bufoffset, fields[fieldnum].length, opttrimpadding);
-                    break;
-                case 'D':
-                    /* Datestamps */
-                    if(bufoffset[0] == ' ' || bufoffset[0] == '\0') {
-                        printf("\\N");
-                    } else {
-                        s = outputbuffer;
-                        *s++ = bufoffset[0];
-                        *s++ = bufoffset[1];
-                        *s++ = bufoffset[2];
-                        *s++ = bufoffset[3];
-                        *s++ = '-';
-                        *s++ = bufoffset[4];
-                        *s++ = bufoffset[5];
-                        *s++ = '-';
-                        *s++ = bufoffset[6];
-                        *s++ = bufoffset[7];
-                        *s++ = '\0';
-                        printf("%s", outputbuffer);
-                    }
-                    break;
-                case 'G':
-                    /* General binary objects */
-                    /* This is left unimplemented to avoid breakage for
-                     * people porting databases with OLE objects, at least
-                     * until someone comes up with a good way to display
-                     * them. */
+        /* The records normally go into a single COPY. With a checkpoint
+         * file, each batch gets a COPY and a transaction of its own, and
+         * the checkpoint only moves past a batch once the server has
+         * committed it. */
+        recordnumber = firstrecord;
+        do {
+            /* Get PostgreSQL ready to receive lots of input. If the data
+             * is going to a separate file, the command to load it is
+             * written after that file is complete. */
+#if defined(HAVE_LIBPQ)
+            if(conn != NULL) {
+                runstatements(conn, output);
+                startcopy(conn, copycommand, &dataoutput);
+            } else
+#endif
+            if(delta) {
+                outbufprintf(output, "CREATE TEMPORARY TABLE %s (LIKE %s);\n", deltatablename, baretablename);
+                outbufprintf(output, "\\COPY %s FROM STDIN\n", deltatablename);
+            } else if(optdatafile == NULL) {
+                outbufprintf(output, "\\COPY %s FROM STDIN%s\n", baretablename, copyoptions);
+            }
+            if(optbinary) {
+                writebinaryheader(copyoutput);
+            }
+
+            /* Loop across records in the file, taking 'dbfbatchsize' at a
+             * time, and output them in PostgreSQL-compatible format */
+            for(;;) {
+                started = statsclock(stats);
+                blocksread = readdbfbatch(&dbfreader, &records);
+                statsphase(stats, STATREAD, started);
+                if(!blocksread) {
                     break;
-                case 'I':
-                    /* Integers */
-                    printf("%d", slittleint32_t(bufoffset));
+                }
+                if(memomap != NULL) {
+                    started = statsclock(stats);
+                    prefetchmemos(&memoprefetch, &formatters[0].arena, &table, records, blocksread);
+                    statsphase(stats, STATMEMO, started);
+                }
+                started = statsclock(stats);
+                if(!delta) {
+                    formatbatch(copyoutput, formatters, optjobs, &table, records, blocksread);
+                }
+                if(optfingerprints != NULL) {
+                    fingerprintbatch(&fingerprints, &formatters[0], records, blocksread);
+                }
+                for(i = 0; i < optjobs; i++) {
+                    resetarena(&formatters[i].arena);
+                }
+                statsphase(stats, STATFORMAT, started);
+                if(stats != NULL) {
+                    stats->bytesin += blocksread * table.recordlength;
+                }
+                recordnumber += blocksread;
+                if(optshowprogress && !optbatch) {
+                    updateprogressbar(100 * (recordnumber - firstrecord) / (lastrecord - firstrecord));
+                }
+                if(optcheckpoint != NULL) {
                     break;
-                case 'L':
-                    /* Booleans */
-                    switch(bufoffset[0]) {
-                    case 'Y':
-                    case 'T':
-                        putchar('t');
-                        break;
-                    default:
-                        putchar('f');
-                        break;
+                }
+            }
+
+            if(optbinary) {
+                writebinarytrailer(copyoutput);
+            }
+#if defined(HAVE_LIBPQ)
+            if(conn != NULL) {
+                finishcopy(conn, &dataoutput, tablename);
+            } else
+#endif
+            if(optdatafile == NULL) {
+                outbufprintf(output, "\\.\n");
+            } else {
+                freeoutbuf(&dataoutput);
+                if(close(datafd) == -1) {
+                    exitwitherror("Unable to close the data file", 1);
+                }
+                outbufprintf(output, "\\COPY %s FROM ", baretablename);
+                outbufquoted(output, optdatafile);
+                outbufprintf(output, "%s\n", copyoptions);
+            }
+
+            /* A delta replaces the rows whose records changed and deletes
+             * the ones whose records are gone */
+            if(optfingerprints != NULL) {
+                finishfingerprints(&fingerprints);
+                if(delta) {
+                    outbufprintf(output, "CREATE TEMPORARY TABLE %s AS SELECT ", gonetablename);
+                    for(i = 0; i < indexcount; i++) {
+                        outbufprintf(output, "%s%s", i ? ", " : "", indexcolumns[i]);
                     }
-                    break;
-                case 'M':
-                    /* Memos */
-                    if(pgfields[fieldnum].memonumbering == PACKEDMEMOSTYLE) {
-                        memoblocknumber = slittleint32_t(bufoffset);
-                    } else {
-                        memoblocknumber = 0;
-                        s = bufoffset;
-                        for(i = 0; i < 10; i++) {
-                            if(*s && *s != 32) {
-                                /* I'm unaware of any non-ASCII
-                                 * implementation of XBase. */
-                                memoblocknumber = memoblocknumber * 10 + *s - '0';
-                            }
-                            s++;
-                        }
+                    outbufprintf(output, " FROM %s WITH NO DATA;\n", baretablename);
+                    outbufprintf(output, "\\COPY %s FROM STDIN\n", gonetablename);
+                    outbufwrite(output, fingerprints.keyformatter.output->data, fingerprints.keyformatter.output->length);
+                    /* Plain equality lets PostgreSQL use the key's index
+                     * or a hash join. Only when an old key had a NULL does
+                     * a second, slower pass match those. */
+                    outbufprintf(output, "\\.\nDELETE FROM %s AS target USING %s AS gone WHERE ", baretablename, gonetablename);
+                    for(i = 0; i < indexcount; i++) {
+                        outbufprintf(output, "%starget.%s = gone.%s", i ? " AND " : "", indexcolumns[i], indexcolumns[i]);
                     }
-                    if(memoblocknumber) {
-                        memorecordoffset = memoblocksize * memoblocknumber;
-                        if(memorecordoffset >= memofilesize) {
-                            exitwitherror("A memo record past the end of the memofile was requested", 0);
+                    if(fingerprints.nullkeys) {
+                        outbufprintf(output, ";\nDELETE FROM %s AS target USING %s AS gone WHERE (", baretablename, gonetablename);
+                        for(i = 0; i < indexcount; i++) {
+                            outbufprintf(output, "%sgone.%s IS NULL", i ? " OR " : "", indexcolumns[i]);
                         }
-                        memorecord = memomap + memorecordoffset;
-                        if(memofileisdbase3) {
-                            t = strchr(memorecord, 0x1A);
-                            safeprintbuf(memorecord, t - memorecord, opttrimpadding);
-                        } else {
-                            safeprintbuf(memorecord + 8, sbigint32_t(memorecord + 4), opttrimpadding);
+                        outbufprintf(output, ")");
+                        for(i = 0; i < indexcount; i++) {
+                            outbufprintf(output, " AND target.%s IS NOT DISTINCT FROM gone.%s", indexcolumns[i], indexcolumns[i]);
                         }
                     }
-                    break;
-                case 'F':
-                case 'N':
-                    /* Numerics */
-                    strncpy(outputbuffer, bufoffset, fields[fieldnum].length);
-                    outputbuffer[fields[fieldnum].length] = '\0';
-                    /* Strip off *leading* spaces */
-                    s = outputbuffer;
-                    while(*s == ' ') {
-                        s++;
-                    }
-                    if(*s == '\0') {
-                        printf("\\N");
-                    } else {
-                        printf("%s", s);
-                    }
-                    break;
-                case 'T':
-                    /* Timestamps */
-                    juliandays = slittleint32_t(bufoffset);
-                    seconds = (slittleint32_t(bufoffset + 4) + 1) / 1000;
-                    if(!(juliandays || seconds)) {
-                        printf("\\N");
-                    } else {
-                        hours = seconds / 3600;
-                        seconds -= hours * 3600;
-                        minutes = seconds / 60;
-                        seconds -= minutes * 60;
-                        printf("J%d %02d:%02d:%02d", juliandays, hours, minutes, seconds);
-                    }
-                    break;
-                case 'Y':
-                    /* Currency */
-                    t = outputbuffer + sprintf(outputbuffer, "%05"PRId64, slittleint64_t(bufoffset));
-                    *(t + 1) = '\0';
-                    *(t) = *(t - 1);
-                    *(t - 1) = *(t - 2);
-                    *(t - 2) = *(t - 3);
-                    *(t - 3) = *(t - 4);
-                    *(t - 4) = '.';
-                    printf("%s", outputbuffer);
-                    break;
-                };
-                printedfieldcount++;
-                bufoffset += fields[fieldnum].length;
+                    outbufprintf(output, ";\nINSERT INTO %s SELECT * FROM %s;\n", baretablename, deltatablename);
+                    outbufprintf(output, "DROP TABLE %s, %s;\n", deltatablename, gonetablename);
+                    fprintf(stderr, "Found %lu new, %lu changed, and %lu deleted records\n", (unsigned long) fingerprints.added,
+                            (unsigned long) fingerprints.changed, (unsigned long) fingerprints.removed);
+                }
+                freeformatter(&fingerprints.keyformatter);
+                free(keyplan);
+                free(deltatablename);
+                free(gonetablename);
+            }
+
+            /* An unlogged table is written to the WAL in one pass before
+             * it's committed, so it's never left unlogged after a crash */
+            if(optunlogged) {
+                outbufprintf(output, "ALTER TABLE %s SET LOGGED;\n", baretablename);
+            }
+
+            /* Until this point, no changes have been flushed to the
+             * database */
+            if(optcheckpoint != NULL) {
+                writeserverprogress(output, tablename, recordnumber, 0);
             }
-            printf("\n");
+            if(optusetransaction) {
+                outbufprintf(output, "COMMIT;\n");
+            }
+
+            if(optcheckpoint != NULL) {
+#if defined(HAVE_LIBPQ)
+                runstatements(conn, output);
+#endif
+                writecheckpoint(optcheckpoint, tablename, table.recordlength, recordnumber, 0);
+                if(optusetransaction && recordnumber < lastrecord) {
+                    outbufprintf(output, "BEGIN;\n");
+                }
+            }
+        } while(optcheckpoint != NULL && recordnumber < lastrecord);
+        if(stats != NULL) {
+            stats->memosprefetched += memoprefetch.memocount;
+            stats->memoranges += memoprefetch.rangecount;
         }
-        if(optshowprogress) {
-            updateprogressbar(100 * (recordbase + blocksread) / littleint32_t(dbfheader.recordcount));
+
+        if(optshowprogress && !optbatch) {
+            updateprogressbar(100);
+            if(memomap != NULL) {
+                fprintf(stderr, "Prefetched %lu memos in %lu ranges\n",
+                        (unsigned long) memoprefetch.memocount, (unsigned long) memoprefetch.rangecount);
+            }
+            for(i = 0, arenapeak = 0; i < optjobs; i++) {
+                if(formatters[i].arena.peak > arenapeak) {
+                    arenapeak = formatters[i].arena.peak;
+                }
+            }
+            fprintf(stderr, "Used at most %lu bytes of scratch memory per formatter\n", (unsigned long) arenapeak);
+        }
+        freedbfreader(&dbfreader);
+        for(i = 0; i < optjobs; i++) {
+            freeformatter(&formatters[i]);
+        }
+        free(formatters);
+        free(plan);
+        if(jobstats != NULL) {
+            for(i = 0; i < optjobs; i++) {
+                addstats(stats, &jobstats[i]);
+            }
+            free(jobstats);
+        }
+#if defined(HAVE_LIBPQ)
+        if(conn != NULL) {
+            free(copycommand);
+            freeoutbuf(&dataoutput);
         }
+#endif
     }
-    if(optshowprogress) { updateprogressbar(100); }
-    free(inputbuffer);
-    free(outputbuffer);
-    printf("\\.\n");
 
-    /* Until this point, no changes have been flushed to the database */
-    if(optusetransaction) {
-        printf("COMMIT;\n");
+    /* Give the index builds room to sort in memory and in parallel */
+    if(optfastload && indexcount) {
+        outbufprintf(output, "SET maintenance_work_mem = '%lukB';\n", (unsigned long) (optindexmemory / 1024));
+        outbufprintf(output, "SET max_parallel_maintenance_workers = %d;\n", optindexworkers);
     }
 
-    /* Generate the indexes */
-    for(i = optind + 1; i < argc; i++ ){
-        printf("CREATE INDEX %s_", tablename);
-        for(s = argv[i]; *s; s++) {
+    /* Generate the indexes. A delta's table already has them, and so does
+     * a finished checkpoint's. A checkpointed load builds them in a last
+     * transaction that also marks it finished on the server. */
+    if(optcheckpoint != NULL && !loaded) {
+        outbufprintf(output, "BEGIN;\n");
+    }
+    for(i = 0; i < indexcount && !delta && !loaded; i++ ){
+        outbufprintf(output, "CREATE INDEX %s_", tablename);
+        for(s = indexcolumns[i]; *s; s++) {
             if(isalnum(*s)) {
-                putchar(*s);
+                outbufputc(output, *s);
                 lastcharwasreplaced = 0;
             } else {
                 /* Only output one underscore in a row */
                 if(!lastcharwasreplaced) {
-                    putchar('_');
+                    outbufputc(output, '_');
                     lastcharwasreplaced = 1;
                 }
             }
         }
-        printf(" ON %s(%s);\n", baretablename, argv[i]);
+        outbufprintf(output, " ON %s(%s);\n", baretablename, indexcolumns[i]);
+    }
+    if(optfastload) {
+        if(indexcount) {
+            outbufprintf(output, "RESET maintenance_work_mem;\nRESET max_parallel_maintenance_workers;\n");
+        }
+        outbufprintf(output, "ANALYZE %s;\n", baretablename);
+    }
+    if(optcheckpoint != NULL && !loaded) {
+        writeserverprogress(output, tablename, lastrecord, 1);
+        outbufprintf(output, "COMMIT;\n");
+    }
+#if defined(HAVE_LIBPQ)
+    if(conn != NULL) {
+        runstatements(conn, output);
+        PQfinish(conn);
+    }
+#endif
+    /* Only call the load finished once the indexes exist, so that running
+     * it again doesn't try to build them twice */
+    if(optcheckpoint != NULL && !loaded) {
+        writecheckpoint(optcheckpoint, tablename, table.recordlength, lastrecord, 1);
     }
 
     free(tablename);
     free(baretablename);
-    free(fields);
-    for(fieldnum = 0; fieldnum < fieldcount; fieldnum++) {
-        if(pgfields[fieldnum].formatstring != NULL) {
-            free(pgfields[fieldnum].formatstring);
-        }
+    if(usefieldnames) {
+        free(fieldnames);
     }
+    free(filters);
+    free(fields);
     free(pgfields);
-    fclose(dbffile);
+    closedbfreader(&dbfreader);
     if(memomap != NULL) {
-        if(munmap(memomap, memostat.st_size) == -1) {
+        if(munmap(memomap, memofilesize) == -1) {
             exitwitherror("Unable to munmap the memofile", 1);
         }
         close(memofd);
     }
 
-#if defined(HAVE_ICONV)
-    if(conv_desc != NULL) {
-        if(iconv_close(conv_desc) != 0) {
-            fprintf(stderr, "iconv_close failed: %s\n", strerror(errno));
-            exit(1);
+}
+
+static void *batchworker(void *arg) {
+    /* Convert tables from the batch until there are none left. Each worker
+     * keeps one output buffer for all of its tables. */
+    BATCH      *batch = (BATCH *) arg;
+    BATCHTABLE *batchtable;
+    OUTBUF      output;
+    COMPRESSOR  compressor;
+    STATS       stats;
+    char       *outputfilename;
+    int         outputfd = -1;
+
+    initoutbuf(&output, -1, optflushsize);
+    if(optstats) {
+        memset(&stats, 0, sizeof(stats));
+        output.stats = &stats;
+    }
+    while((batchtable = nextbatchtable(batch)) != NULL) {
+        if(optoutputdir != NULL) {
+            if(asprintf(&outputfilename, "%s/%s.sql%s", optoutputdir, batchtable->tablename,
+                        COMPRESSSUFFIXES[optcompress]) < 0) {
+                exitwitherror("Unable to allocate an output filename", 1);
+            }
+            outputfd = open(outputfilename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if(outputfd == -1) {
+                fprintf(stderr, "Unable to open %s: %s\n", outputfilename, strerror(errno));
+                exit(EXIT_FAILURE);
+            }
+            retargetoutbuf(&output, outputfd);
+            startoutput(&output, &compressor);
+        }
+        converttable(batchtable->dbffilename, batchtable->memofilename, &output, NULL, 0);
+        if(optoutputdir != NULL) {
+            endoutput(&output, &compressor);
+            retargetoutbuf(&output, -1);
+            if(close(outputfd) == -1) {
+                exitwitherror("Unable to close an output file", 1);
+            }
+            if(optshowprogress) {
+                fprintf(stderr, "Converted %s to %s\n", batchtable->dbffilename, outputfilename);
+            }
+            free(outputfilename);
+        } else if(optshowprogress) {
+            fprintf(stderr, "Loaded %s\n", batchtable->dbffilename);
         }
     }
+    freeoutbuf(&output);
+    if(optstats) {
+#if defined(HAVE_PTHREAD)
+        pthread_mutex_lock(&batch->lock);
+#endif
+        addstats(&batch->stats, &stats);
+#if defined(HAVE_PTHREAD)
+        pthread_mutex_unlock(&batch->lock);
+#endif
+    }
+    return NULL;
+}
+
+static void convertbatch(char **paths, const int pathcount, STATS *stats) {
+    /* Convert every DBF file named in paths, or found in the directories
+     * named there, running up to optbatchjobs conversions at once. The
+     * workers' stats are added to stats. */
+    BATCH     batch;
+    int       workercount;
+#if defined(HAVE_PTHREAD)
+    pthread_t workers[MAXJOBS];
+    int       i;
+#endif
+
+    initbatch(&batch, paths, pathcount);
+    workercount = optbatchjobs;
+    if(!workercount) {
+        workercount = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if(workercount < 1) {
+        workercount = 1;
+    }
+    if(workercount > MAXJOBS) {
+        workercount = MAXJOBS;
+    }
+    if((size_t) workercount > batch.tablecount) {
+        workercount = batch.tablecount;
+    }
+    /* Tables converted at the same time share --max-memory evenly */
+    if(workercount > 1) {
+        tablememory = optmaxmemory / workercount;
+    }
+
+#if defined(HAVE_PTHREAD)
+    if(workercount > 1) {
+        for(i = 0; i < workercount; i++) {
+            if(pthread_create(&workers[i], NULL, batchworker, &batch)) {
+                exitwitherror("Unable to start a batch worker", 0);
+            }
+        }
+        for(i = 0; i < workercount; i++) {
+            if(pthread_join(workers[i], NULL)) {
+                exitwitherror("Unable to join a batch worker", 0);
+            }
+        }
+    } else
 #endif
+    batchworker(&batch);
+    addstats(stats, &batch.stats);
+    freebatch(&batch);
+}
+
+int main(int argc, char **argv) {
+    OUTBUF      output;
+    COMPRESSOR  compressor;
+    STATS       stats;
+    struct stat dbfstat;
+    uint64_t    started;
+    char       *memofilename = NULL;
+
+    /* Command line option parsing */
+    int      opt;
+    int      optexitcode = -1;  /* Left at -1 means that the arguments were
+                                 * valid and the program should run.
+                                 * Anything else is an exit code and the
+                                 * program will stop. */
+    char     optvalidargs[sizeof(STANDARDOPTS) + 2];
+
+    strcpy(optvalidargs, STANDARDOPTS);
+#if defined(HAVE_PTHREAD)
+    /* Note that the declaration for optvalidargs currently reserves exactly
+     * two extra chars for this value. If you change this value, be sure to
+     * alter the optvalidargs declaration accordingly! */
+    strcat(optvalidargs, "j:");
+#endif
+
+    /* Attempt to parse any command line arguments */
+    while((opt = getopt_long(argc, argv, optvalidargs, LONGOPTS, NULL)) != -1) {
+        switch(opt) {
+        case 'c':
+            optusecreatetable = 1;
+            optusetruncatetable = 0;
+            break;
+        case 'C':
+            optusecreatetable = 0;
+            break;
+        case 'd':
+            optusedroptable = 1;
+            optusetruncatetable = 0;
+            break;
+        case 'D':
+            optusedroptable = 0;
+            break;
+        case 'e':
+            optuseifexists = 1;
+            break;
+        case 'E':
+            optuseifexists = 0;
+            break;
+        case 'j':
+            optjobs = atoi(optarg);
+            if(optjobs < 1 || optjobs > MAXJOBS) {
+                fprintf(stderr, "The number of jobs must be between 1 and %d\n", MAXJOBS);
+                optexitcode = EXIT_FAILURE;
+            }
+            break;
+        case 'i':
+            optignorefields = 1;
+            ignorefields = splitfieldnames(optarg, &ignorefieldcount);
+            break;
+        case 'm':
+            memofilename = optarg;
+            break;
+        case 'n':
+            optnumericasnumeric = 1;
+            break;
+        case 'N':
+            optnumericasnumeric = 0;
+            break;
+        case 'p':
+            optshowprogress = 1;
+            break;
+        case 'P':
+            optshowprogress = 0;
+            break;
+        case 'q':
+            optusequotedtablename = 1;
+            break;
+        case 'Q':
+            optusequotedtablename = 0;
+            break;
+        case 'r':
+            opttrimpadding = 1;
+            break;
+        case 'R':
+            opttrimpadding = 0;
+            break;
+        case 's':
+            optinputcharset = optarg;
+            break;
+        case 't':
+            optusetransaction = 1;
+            break;
+        case 'T':
+            optusetransaction = 0;
+            break;
+        case 'u':
+            optusetruncatetable = 1;
+            optusecreatetable = 0;
+            optusedroptable = 0;
+            break;
+        case 'U':
+            optusetruncatetable = 0;
+            break;
+        case LONGOPTBATCH:
+            optbatch = 1;
+            break;
+        case LONGOPTBATCHJOBS:
+            optbatchjobs = atoi(optarg);
+            if(optbatchjobs < 1 || optbatchjobs > MAXJOBS) {
+                fprintf(stderr, "The number of batch jobs must be between 1 and %d\n", MAXJOBS);
+                optexitcode = EXIT_FAILURE;
+            }
+            break;
+        case LONGOPTBINARY:
+            optbinary = 1;
+            break;
+        case LONGOPTCONNECT:
+            optconninfo = optarg;
+            break;
+        case LONGOPTDATAFILE:
+            optdatafile = optarg;
+            break;
+        case LONGOPTNOMMAP:
+            optmmap = 0;
+            break;
+        case LONGOPTOUTPUTDIR:
+            optoutputdir = optarg;
+            break;
+        case LONGOPTSTATS:
+            optstats = 1;
+            break;
+        case LONGOPTSTARTRECORD:
+            if(!parsecount(optarg, &optstartrecord)) {
+                fprintf(stderr, "Invalid start record: %s\n", optarg);
+                optexitcode = EXIT_FAILURE;
+            }
+            break;
+        case LONGOPTENDRECORD:
+            if(!parsecount(optarg, &optendrecord)) {
+                fprintf(stderr, "Invalid end record: %s\n", optarg);
+                optexitcode = EXIT_FAILURE;
+            }
+            break;
+        case LONGOPTCHECKPOINT:
+            optcheckpoint = optarg;
+            break;
+        case LONGOPTSHARDS:
+            optshards = atoi(optarg);
+            if(optshards < 1 || optshards > MAXJOBS) {
+                fprintf(stderr, "The number of shards must be between 1 and %d\n", MAXJOBS);
+                optexitcode = EXIT_FAILURE;
+            }
+            break;
+        case LONGOPTOUTPUTPREFIX:
+            optoutputprefix = optarg;
+            break;
+        case LONGOPTFINGERPRINTS:
+            optfingerprints = optarg;
+            break;
+        case LONGOPTINCLUDE:
+            optincludefields = 1;
+            includefields = splitfieldnames(optarg, &includefieldcount);
+            break;
+        case LONGOPTWHERE:
+            optwhere = realloc(optwhere, (optwherecount + 1) * sizeof(char *));
+            if(optwhere == NULL) {
+                exitwitherror("Unable to realloc the --where list", 1);
+            }
+            optwhere[optwherecount++] = optarg;
+            break;
+        case LONGOPTCOMPRESS:
+            if(!strcmp(optarg, "zstd")) {
+#if defined(HAVE_ZSTD)
+                optcompress = COMPRESSZSTD;
+#else
+                fprintf(stderr, "This copy of %s was built without zstd support\n", PACKAGE);
+                optexitcode = EXIT_FAILURE;
+#endif
+            } else if(!strcmp(optarg, "gzip")) {
+#if defined(HAVE_ZLIB)
+                optcompress = COMPRESSGZIP;
+#else
+                fprintf(stderr, "This copy of %s was built without gzip support\n", PACKAGE);
+                optexitcode = EXIT_FAILURE;
+#endif
+            } else {
+                fprintf(stderr, "Unknown compression method: %s\n", optarg);
+                optexitcode = EXIT_FAILURE;
+            }
+            break;
+        case LONGOPTCOMPRESSLEVEL:
+            optcompresslevel = atoi(optarg);
+            if(optcompresslevel < 1) {
+                fprintf(stderr, "Invalid compression level: %s\n", optarg);
+                optexitcode = EXIT_FAILURE;
+            }
+            break;
+        case LONGOPTCOMPRESSTHREADS:
+            optcompressthreads = atoi(optarg);
+            if(optcompressthreads < 1 || optcompressthreads > MAXJOBS) {
+                fprintf(stderr, "The number of compression threads must be between 1 and %d\n", MAXJOBS);
+                optexitcode = EXIT_FAILURE;
+            }
+            break;
+        case LONGOPTFLUSHSIZE:
+            optflushsize = parsesize(optarg);
+            if(!optflushsize) {
+                fprintf(stderr, "Invalid flush size: %s\n", optarg);
+                optexitcode = EXIT_FAILURE;
+            }
+            break;
+        case LONGOPTFASTLOAD:
+            optfastload = 1;
+            break;
+        case LONGOPTUNLOGGED:
+            optunlogged = 1;
+            break;
+        case LONGOPTINDEXMEMORY:
+            optindexmemory = parsesize(optarg);
+            if(optindexmemory < 1024) {
+                fprintf(stderr, "Invalid index memory size: %s\n", optarg);
+                optexitcode = EXIT_FAILURE;
+            }
+            break;
+        case LONGOPTINDEXWORKERS:
+            optindexworkers = atoi(optarg);
+            if(optindexworkers < 0 || optindexworkers > 1024) {
+                fprintf(stderr, "The number of index workers must be between 0 and 1024\n");
+                optexitcode = EXIT_FAILURE;
+            }
+            break;
+        case LONGOPTNARROWTYPES:
+            optnarrowtypes = 1;
+            break;
+        case LONGOPTMAXMEMORY:
+            optmaxmemory = parsesize(optarg);
+            if(!optmaxmemory) {
+                fprintf(stderr, "Invalid memory limit: %s\n", optarg);
+                optexitcode = EXIT_FAILURE;
+            }
+            break;
+        case 'h':
+        default:
+            /* If we got here because someone requested '-h', exit
+             * successfully.  Otherwise they used an invalid option, so
+             * fail. */
+            optexitcode = ((char) opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE);
+        }
+    }
+
+    /* Checking that the user specified a filename, unless we're already
+     * exiting for other reasons in which case it doesn't matter */
+    if(optexitcode != EXIT_SUCCESS && optind > (argc - 1)) {
+        optexitcode = EXIT_FAILURE;
+    }
+
+    if(optexitcode != -1) {
+        printf(
+               "Usage: %s [-cCdDeEhtTuU]"
+#if defined(HAVE_PTHREAD)
+               " [-j jobs]"
+#endif
+               " [-s encoding]"
+               " [-m memofilename] [-i fieldname1,fieldname2,fieldnameN]\n"
+               "       [--binary] [--data-file filename] [--flush-size bytes] [--no-mmap] [--stats]"
+#if defined(HAVE_LIBPQ)
+               " [--connect conninfo]"
+#endif
+               "\n"
+               "       [--start-record n] [--end-record n] [--checkpoint filename]\n"
+               "       [--shards n --output-prefix prefix] [--fingerprints filename]\n"
+               "       [--compress method [--compress-level n] [--compress-threads n]]\n"
+               "       [--include fieldname1,fieldname2,fieldnameN] [--where condition] [--max-memory bytes]\n"
+               "       [--fast-load [--unlogged] [--index-memory bytes] [--index-workers n]] [--narrow-types]\n"
+               "       filename [indexcolumn ...]\n"
+               "       %s --batch [--batch-jobs jobs] --output-dir directory [options] path ...\n"
+               "Convert the named XBase file into PostgreSQL format\n"
+               "\n"
+               "  -c  issue a 'CREATE TABLE' command to create the table (default)\n"
+               "  -C  do not issue a 'CREATE TABLE' command\n"
+               "  -d  issue a 'DROP TABLE' command before creating the table (default)\n"
+               "  -D  do not issue a 'DROP TABLE' command\n"
+               "  -e  use 'IF EXISTS' when dropping tables (PostgreSQL 8.2+) (default)\n"
+               "  -E  do not use 'IF EXISTS' when dropping tables (PostgreSQL 8.1 and older)\n"
+               "  -h  print this message and exit\n"
+               "  -i  ignore fields\n"
+#if defined(HAVE_PTHREAD)
+               "  -j  format records with this many worker threads (default 1)\n"
+#endif
+               "  -m  the name of the associated memo file (if necessary)\n"
+               "  -n  use type 'NUMERIC' for NUMERIC fields (default)\n"
+               "  -N  use type 'TEXT' for NUMERIC fields\n"
+               "  -r  remove padding at the end of TEXT and VARCHAR fields (default)\n"
+               "  -R  keep padding at the end of TEXT and VARCHAR fields\n"
+               "  -p  show a progress bar during processing\n"
+               "  -P  do not show a progress bar\n"
+               "  -q  enclose the table name in quotation marks whenever used in statements\n"
+               "  -Q  do not enclose the table name in quotation marks (default)\n"
+               "  -s  the encoding used in the file, to be converted to UTF-8, or 'auto'\n"
+               "  -t  wrap a transaction around the entire series of statements (default)\n"
+               "  -T  do not use an enclosing transaction\n"
+               "  -u  issue a 'TRUNCATE' command before inserting data\n"
+               "  -U  do not issue a 'TRUNCATE' command before inserting data (default)\n"
+               "\n"
+               "  --batch             convert every DBF file named, or found in the named directories\n"
+               "  --batch-jobs jobs   with --batch, convert this many tables at once (default one per CPU)\n"
+               "  --binary            write the data in PostgreSQL's binary COPY format (needs --data-file\n"
+               "                      or --connect)\n"
+#if defined(HAVE_LIBPQ)
+               "  --checkpoint file   with --connect, commit each batch of records separately and record\n"
+               "                      the progress in file, so that running again with the same file\n"
+               "                      resumes the load\n"
+#endif
+               "  --compress method   compress the script with zstd or gzip as it's written\n"
+               "  --compress-level n  the compression level (default 3 for zstd, 6 for gzip)\n"
+               "  --compress-threads n\n"
+               "                      with zstd, compress with this many extra threads\n"
+#if defined(HAVE_LIBPQ)
+               "  --connect conninfo  load the table directly into this database instead of printing a script\n"
+#endif
+               "  --data-file file    write the data to this file instead of into the script\n"
+               "  --end-record n      stop after the first n records\n"
+               "  --fast-load         load the rows already frozen, give the index builds more memory and\n"
+               "                      parallel workers, and analyze the table afterward\n"
+               "  --fingerprints file load only the records that changed since the fingerprints in file\n"
+               "                      were taken, matching rows by the index columns, and write new\n"
+               "                      fingerprints to file.new\n"
+               "  --flush-size bytes  write output in chunks of about this size (default 1M)\n"
+               "  --include fields    only convert these fields (the opposite of -i)\n"
+               "  --index-memory bytes\n"
+               "                      with --fast-load, the maintenance_work_mem for the indexes (default 1G)\n"
+               "  --index-workers n   with --fast-load, the parallel workers for each index (default 4)\n"
+               "  --max-memory bytes  size batches, scratch memory and memo reads to stay within about\n"
+               "                      this much memory, and fail rather than use more\n"
+               "  --narrow-types      read the records once before creating the table, and make whole\n"
+               "                      number columns SMALLINT, INTEGER, or BIGINT and trimmed text\n"
+               "                      columns as short as their longest value\n"
+               "  --no-mmap           read the DBF file with ordinary reads instead of mapping it into memory\n"
+               "  --output-dir dir    with --batch, write each table's script to dir/tablename.sql\n"
+               "  --output-prefix p   with --shards, write prefix.schema.sql, prefix.0.sql, ..., and\n"
+               "                      prefix.post.sql\n"
+               "  --shards n          split the data into n scripts, written in parallel, that can be\n"
+               "                      loaded at the same time\n"
+               "  --start-record n    skip the first n records\n"
+               "  --stats             print counters and timings for each phase to stderr as JSON\n"
+               "  --unlogged          with --fast-load, create the table unlogged and log it in one pass\n"
+               "                      before committing\n"
+               "  --where condition   only convert records where a field compares to a value, like\n"
+               "                      \"saledate>=20240101\" or \"status='A'\". May be given more than once.\n"
+               "\n"
+               "If you don't specify an encoding via '-s', the data will be printed as is.\n"
+               "With '-s auto', the encoding is taken from the language byte in the file's header.\n"
+               "Using '-u' implies '-C -D'. Using '-c' or '-d' implies '-U'.\n"
+               "With '--batch', memo files are found automatically and indexes can't be given.\n"
+               "Resuming from a checkpoint implies '-C -D -U'.\n"
+               "\n"
+               "%s is copyright 2008-2012 kirk@strauser.com.\n"
+               "License GPLv3+: GNU GPL version 3 or later <http://gnu.org/licenses/gpl.html>\n"
+               "This is free software: you are free to change and redistribute it.\n"
+               "There is NO WARRANTY, to the extent permitted by law.\n"
+               "Report bugs to <%s>\n", PACKAGE, PACKAGE, PACKAGE_STRING, PACKAGE_BUGREPORT);
+        exit(optexitcode);
+    }
+
+    /* Sanity check the arguments */
+    if(!optusecreatetable) {
+        /* It makes no sense to drop the table without creating it
+         * afterward */
+        optusedroptable = 0;
+    }
+    if(optbinary && optdatafile == NULL && optconninfo == NULL) {
+        /* psql reads binary COPY data until the end of its input, so it
+         * can't be followed by the rest of the script. */
+        exitwitherror("Binary output needs a separate data file. Use --data-file or --connect.", 0);
+    }
+    if(optdatafile != NULL && optconninfo != NULL) {
+        exitwitherror("--data-file can't be used with --connect", 0);
+    }
+    if(optbatch) {
+        if(optoutputdir == NULL && optconninfo == NULL) {
+            exitwitherror("--batch needs --output-dir or --connect", 0);
+        }
+        if(memofilename != NULL) {
+            exitwitherror("-m can't be used with --batch. Memo files are found automatically.", 0);
+        }
+        if(optdatafile != NULL) {
+            exitwitherror("--data-file can't be used with --batch", 0);
+        }
+        if(optoutputdir != NULL && optconninfo != NULL) {
+            exitwitherror("--output-dir can't be used with --connect", 0);
+        }
+        if(optstartrecord || optendrecord != SIZE_MAX || optcheckpoint != NULL) {
+            exitwitherror("--start-record, --end-record, and --checkpoint can't be used with --batch", 0);
+        }
+    } else if(optoutputdir != NULL || optbatchjobs) {
+        exitwitherror("--output-dir and --batch-jobs can only be used with --batch", 0);
+    }
+    if((optshards != 0) != (optoutputprefix != NULL)) {
+        exitwitherror("--shards and --output-prefix have to be used together", 0);
+    }
+    if(optshards && (optbatch || optconninfo != NULL || optdatafile != NULL || optcheckpoint != NULL ||
+                     optbinary || optjobs > 1)) {
+        exitwitherror("--shards can't be used with --batch, --connect, --data-file, --checkpoint, --binary, or -j", 0);
+    }
+    if(optshards && (compressionmethod(argv[optind]) != COMPRESSNONE || stat(argv[optind], &dbfstat) == -1 ||
+                     !S_ISREG(dbfstat.st_mode))) {
+        /* Every shard reads its own part of the file */
+        exitwitherror("--shards needs an uncompressed DBF file, not a pipe", 0);
+    }
+    if(optfingerprints != NULL) {
+        if(optbatch || optconninfo != NULL || optdatafile != NULL || optcheckpoint != NULL || optshards ||
+           optbinary || optjobs > 1 || optstartrecord || optendrecord != SIZE_MAX) {
+            exitwitherror("--fingerprints can only be used to write a text script of an entire table. It can't be "
+                          "used with --batch, --connect, --data-file, --checkpoint, --shards, --binary, -j, "
+                          "--start-record, or --end-record.", 0);
+        }
+        if(optind + 1 >= argc) {
+            exitwitherror("--fingerprints needs the key columns given after the filename", 0);
+        }
+    }
+    if(optincludefields && optignorefields) {
+        exitwitherror("-i and --include can't be used together", 0);
+    }
+    if(optbatch && (optincludefields || optwherecount)) {
+        /* Every table has different fields */
+        exitwitherror("--include and --where can't be used with --batch", 0);
+    }
+    if(optwherecount && optfingerprints != NULL) {
+        exitwitherror("--where can't be used with --fingerprints", 0);
+    }
+    if(optmaxmemory && optflushsize > optmaxmemory / MEMORYSHARES) {
+        /* The output buffers get what the batches, scratch memory and memos
+         * leave over */
+        exitwitherror("--flush-size can be at most a quarter of --max-memory", 0);
+    }
+    if(optfastload) {
+        if(!optusetransaction || !(optusecreatetable || optusetruncatetable)) {
+            /* COPY only freezes the rows of a table that was created or
+             * truncated in the same transaction */
+            exitwitherror("--fast-load needs -t and either -c or -u", 0);
+        }
+        if(optcheckpoint != NULL || optshards || optfingerprints != NULL) {
+            exitwitherror("--fast-load can't be used with --checkpoint, --shards, or --fingerprints", 0);
+        }
+    } else if(optunlogged || optindexmemory != FASTLOADINDEXMEMORY || optindexworkers != FASTLOADINDEXWORKERS) {
+        exitwitherror("--unlogged, --index-memory, and --index-workers need --fast-load", 0);
+    }
+    if(optunlogged && !optusecreatetable) {
+        exitwitherror("--unlogged needs -c", 0);
+    }
+    if(optnarrowtypes && optcheckpoint != NULL) {
+        /* A resumed load has to format the records for the types that the
+         * first run picked */
+        exitwitherror("--narrow-types can't be used with --checkpoint", 0);
+    }
+    if(optcheckpoint != NULL && optconninfo == NULL) {
+        /* A script's COMMITs are written long before psql runs them, so
+         * only a direct connection knows which batches were committed */
+        exitwitherror("--checkpoint needs --connect", 0);
+    }
+    if(optcheckpoint != NULL && !optusetransaction) {
+        /* Each batch's progress is committed in the same transaction as
+         * its records */
+        exitwitherror("--checkpoint can't be used with -T", 0);
+    }
+
+    if(optcompress == COMPRESSNONE && (optcompresslevel || optcompressthreads)) {
+        exitwitherror("--compress-level and --compress-threads need --compress", 0);
+    }
+    if(optcompress != COMPRESSNONE) {
+        if(optconninfo != NULL || optdatafile != NULL || optcheckpoint != NULL) {
+            /* A checkpoint can't vouch for records that are still waiting
+             * to be compressed */
+            exitwitherror("--compress can't be used with --connect, --data-file, or --checkpoint", 0);
+        }
+        if(optcompress == COMPRESSGZIP && optcompresslevel > 9) {
+            exitwitherror("The gzip compression level must be between 1 and 9", 0);
+        }
+        if(optcompress == COMPRESSGZIP && optcompressthreads) {
+            exitwitherror("--compress-threads can only be used with zstd", 0);
+        }
+#if defined(HAVE_ZSTD)
+        if(optcompress == COMPRESSZSTD && optcompresslevel > ZSTD_maxCLevel()) {
+            fprintf(stderr, "The zstd compression level must be between 1 and %d\n", ZSTD_maxCLevel());
+            exit(EXIT_FAILURE);
+        }
+#endif
+    }
+
+    /* Pick the fastest text scanning routines for this CPU */
+    selectkernels();
+
+    memset(&stats, 0, sizeof(stats));
+    started = monotonicns();
+    tablememory = optmaxmemory;
+    if(optbatch) {
+        convertbatch(argv + optind, argc - optind, &stats);
+    } else {
+        /* Everything from here on is written through the output buffer.
+         * When loading directly, the statements are collected there and
+         * executed in groups instead. */
+        if(optshards) {
+            initoutbuf(&output, openprefixfile("schema.sql"), optflushsize);
+        } else {
+            initoutbuf(&output, optconninfo == NULL ? STDOUT_FILENO : -1, optflushsize);
+        }
+        if(optstats) {
+            output.stats = &stats;
+        }
+        startoutput(&output, &compressor);
+        converttable(argv[optind], memofilename, &output, argv + optind + 1, argc - optind - 1);
+        endoutput(&output, &compressor);
+        freeoutbuf(&output);
+        if(optshards && close(output.fd) == -1) {
+            exitwitherror("Unable to close the post-load script", 1);
+        }
+    }
+    if(optstats) {
+        writestats(stderr, &stats, monotonicns() - started);
+    }
 
     return 0;
 }
@@ -20,19 +20,59 @@
 #define _FILE_OFFSET_BITS 64
 
 #include <config.h>
+#include <stdarg.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/time.h>
 
 #if defined(HAVE_ICONV)
 #include <iconv.h>
 #endif
 
-/* This should be big enough to hold most of the varchars and memo fields
- * that you'll be processing.  If a given piece of data won't fit in a
- * buffer of this size, then a temporary buffer will be allocated for it. */
-#define STATICBUFFERSIZE 1024 * 1024 * 4
+#if defined(HAVE_PTHREAD)
+#include <pthread.h>
+#endif
+
+#if defined(HAVE_LIBPQ)
+#include <libpq-fe.h>
+#endif
+
+#if defined(HAVE_ZSTD)
+#include <zstd.h>
+#endif
+
+#if defined(HAVE_ZLIB)
+#include <zlib.h>
+#endif
+
+/* SSE2 and AVX2 versions of the byte scanning kernels are compiled in on
+ * x86 with GCC or Clang, and chosen at runtime based on what the CPU
+ * supports. Everything else uses the portable versions. */
+#if defined(HAVE_IMMINTRIN_H) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define USEX86SIMD 1
+#include <immintrin.h>
+#endif
+
+/* Memo files that are read into memory are mapped at their full budget up
+ * front. Systems that always reserve swap for anonymous maps just do. */
+#if !defined(MAP_NORESERVE)
+#define MAP_NORESERVE 0
+#endif
+
+/* Output is collected in a buffer and written to stdout once roughly this
+ * many bytes are waiting. It can be changed with "--flush-size". */
+#define OUTBUFFLUSHSIZE 1024 * 1024
+
+/* The most worker threads that "-j" will accept */
+#define MAXJOBS 64
 
 #define IGNORETYPE '9'
 
@@ -40,12 +80,90 @@
  * The actual number may be adjusted up or down as appropriate. */
 #define DBFBATCHTARGET 1024 * 1024 * 16
 
+/* When the .dbf file is memory mapped, ask the kernel to start reading about
+ * this many bytes past the batch that's being formatted. */
+#define DBFREADAHEAD DBFBATCHTARGET
+
+/* Memos closer together than this are prefetched with a single request */
+#define MEMOPREFETCHGAP 64 * 1024
+
+/* Scratch memory for formatting is allocated in chunks of at least this
+ * many bytes */
+#define ARENACHUNKSIZE 64 * 1024
+
+/* Text values are converted and escaped this many bytes at a time, so that
+ * a huge memo takes no more memory than a short one */
+#define VALUEPIECESIZE 64 * 1024
+
+/* The least scratch memory that "--max-memory" can leave a formatter: its
+ * first chunk, plus room to convert one piece of a value to UTF-8 */
+#define ARENAMINIMUM (ARENACHUNKSIZE + 4 * VALUEPIECESIZE + 64)
+
+/* With "--max-memory", each batch of records, the formatters' scratch
+ * memory, and the memo pages read for the batches each get this fraction
+ * of the budget. The rest is left for output buffers. */
+#define MEMORYSHARES 4
+
+/* With "--fast-load", the index builds get this much maintenance_work_mem
+ * and up to this many parallel workers each unless told otherwise */
+#define FASTLOADINDEXMEMORY (1024 * 1024 * 1024)
+#define FASTLOADINDEXWORKERS 4
+
+/* Compressed output is handed to the compression thread in blocks of at
+ * least this many bytes */
+#define COMPRESSBLOCKSIZE 1024 * 1024
+
+/* The comparisons that "--where" understands */
+#define FILTEREQUAL        0
+#define FILTERNOTEQUAL     1
+#define FILTERLESS         2
+#define FILTERLESSEQUAL    3
+#define FILTERGREATER      4
+#define FILTERGREATEREQUAL 5
+
+/* Input is decompressed this many bytes at a time */
+#define DECOMPRESSCHUNKSIZE 128 * 1024
+
+/* The ways "--compress" can compress the output */
+#define COMPRESSNONE 0
+#define COMPRESSZSTD 1
+#define COMPRESSGZIP 2
+
+/* What compressed output files' names end with, by method */
+static const char *COMPRESSSUFFIXES[] = {"", ".zst", ".gz"};
+
+/* A checkpointed load records its progress in this table on the server,
+ * one row per table being loaded */
+#define CHECKPOINTTABLE "pgdbf_checkpoints"
+
+/* Identify a fingerprint file and the byte order it was written in */
+#define FINGERPRINTMAGIC "PGDBFFP1"
+#define FINGERPRINTBYTEORDER 0x01020304
+
+/* The multipliers used by the record hash, borrowed from xxHash */
+#define HASHPRIME1 0x9E3779B185EBCA87ULL
+#define HASHPRIME2 0xC2B2AE3D27D4EB4FULL
+#define HASHPRIME3 0x165667B19E3779F9ULL
+
+/* The phases of a conversion that "--stats" times */
+#define STATHEADER   0          /* Reading the header and field list */
+#define STATREAD     1          /* Getting each batch of records */
+#define STATMEMO     2          /* Prefetching memos */
+#define STATFORMAT   3          /* Formatting records, including the next two */
+#define STATCONVERT  4          /* Converting text to UTF-8 */
+#define STATFLUSH    5          /* Writing or sending output */
+#define STATPHASES   6
+
 /* Old versions of FoxPro (and probably other programs) store the memo file
  * record number in human-readable ASCII. Newer versions of FoxPro store it
  * as a 32-bit packed int. */
 #define NUMERICMEMOSTYLE 0
 #define PACKEDMEMOSTYLE 1
 
+/* Visual FoxPro sets this field flag on memo fields that hold binary data,
+ * which shouldn't go through any character set translation */
+#define BINARYFIELDFLAG 0x04
+
 /* Don't edit this! It's defined in the XBase specification. */
 #define XBASEFIELDNAMESIZE 11
 
@@ -59,8 +177,6 @@
  */
 #define MAXCOLUMNNAMESIZE (XBASEFIELDNAMESIZE + 7)
 
-static char staticbuf[STATICBUFFERSIZE + 1];
-
 /* The list of reserved words that can't be used as column names, as per
  * http://www.postgresql.org/docs/x.y/static/sql-keywords-appendix.html ,
  * for (x.y) in 8.0, 8.1, 8.2, 8.3, 8.4, 9.0. This list includes words
@@ -193,55 +309,358 @@ typedef struct {
 } MEMOHEADER;
 
 typedef struct {
-    char *formatstring;
-    int   memonumbering;
+    int    memonumbering;
+    int    integerwidth;        /* 2, 4, or 8 when "--narrow-types" found
+                                 * only whole numbers that fit SMALLINT,
+                                 * INTEGER, or BIGINT, or 0 */
+    size_t varcharlength;       /* The VARCHAR length "--narrow-types"
+                                 * picked, or 0 for the field's length */
+    int    bytea;               /* Set when a memo is written as BYTEA */
 } PGFIELD;
 
-#if defined(HAVE_ICONV)
-static iconv_t conv_desc = NULL;
+/* Counters and timers for "--stats". Times are in nanoseconds. Each thread
+ * collects its own, and they're added together when it finishes. */
+typedef struct STATS {
+    uint64_t tables;
+    uint64_t records;
+    uint64_t deletedrecords;
+    uint64_t filteredrecords;   /* Skipped because of "--where" */
+    uint64_t bytesin;           /* Read from DBF files */
+    uint64_t bytesout;
+    uint64_t memos;
+    uint64_t memobytes;
+    uint64_t memosprefetched;
+    uint64_t memoranges;        /* Reads the prefetched memos were
+                                 * coalesced into */
+    uint64_t escapes;           /* Characters escaped for COPY */
+    uint64_t buffergrowths;     /* Values too big for the buffers */
+    uint64_t arenapeak;         /* The most scratch memory one formatter
+                                 * held at once */
+    uint64_t phasetime[STATPHASES];
+    uint64_t fieldvalues[256];  /* Indexed by field type */
+    uint64_t fieldtime[256];
+} STATS;
 
-static char* convertcharset(const char* inputstring, size_t* inputsize)
-{
-    char   *inbuf;
-    char   *outbuf;
-    size_t  inbytesleft;
-    size_t  outbyteslen;
-    size_t  outbytesleft;
+/* An append-only output buffer. If sink is NULL, the buffer simply grows
+ * to hold everything that's added to it. Otherwise, its contents are handed
+ * to sink whenever at least flushsize bytes are waiting. The default sink
+ * writes to fd. */
+typedef struct OUTBUF {
+    char   *data;
+    size_t  length;
+    size_t  size;
+    size_t  flushsize;
+    int     fd;
+    void  (*sink)(struct OUTBUF *outbuf, const char *buf, const size_t length);
+    void   *sinkarg;            /* For the use of sinks other than fd's */
+    STATS  *stats;              /* NULL unless collecting stats */
+} OUTBUF;
 
-    inbuf = (char *)inputstring;
-    inbytesleft = *inputsize;
-    outbyteslen = inbytesleft * 4 + 1;
-    outbytesleft = outbyteslen;
-    outbuf = calloc(outbyteslen, 1);
+/* Compresses an output buffer's contents on their way to its file
+ * descriptor. Output is collected in one block while a background thread
+ * compresses and writes the other, and the two swap when the thread is
+ * done. */
+typedef struct {
+    int     method;             /* COMPRESSZSTD or COMPRESSGZIP */
+    int     fd;
+    char   *blocks[2];
+    size_t  lengths[2];
+    size_t  sizes[2];
+    int     filling;            /* The block being added to */
+    char   *compressed;         /* Holds compressed output until it's
+                                 * written */
+    size_t  compressedsize;
+#if defined(HAVE_PTHREAD)
+    pthread_t       thread;
+    pthread_mutex_t lock;
+    pthread_cond_t  changed;
+    int             pending;    /* Set while the thread has a block */
+    int             finished;   /* Set when there are no more blocks */
+#endif
+#if defined(HAVE_ZSTD)
+    ZSTD_CCtx *zstd;
+#endif
+#if defined(HAVE_ZLIB)
+    z_stream   gzip;
+#endif
+} COMPRESSOR;
 
-    char *outbufstart = outbuf;
+/* Reads a compressed file a piece at a time. With COMPRESSNONE it reads the
+ * file as is. */
+typedef struct {
+    int     method;
+    int     fd;
+    char   *input;
+    size_t  inputsize;
+    int     full;               /* The last read filled the caller's buffer,
+                                 * so more output may be waiting */
+    int     ended;              /* The compressed stream ended cleanly */
+#if defined(HAVE_ZSTD)
+    ZSTD_DCtx     *zstd;
+    ZSTD_inBuffer  zstdinput;
+#endif
+#if defined(HAVE_ZLIB)
+    z_stream       gzip;
+#endif
+} DECOMPRESSOR;
 
-    size_t iconv_value = iconv(conv_desc, &inbuf, &inbytesleft, &outbuf, &outbytesleft);
+/* A "--where" condition, tested against the raw bytes of each record
+ * before it's formatted */
+typedef struct {
+    size_t  offset;             /* From the start of the record */
+    size_t  length;
+    char    type;
+    int     comparison;         /* One of the FILTER* values */
+    char    value[256];         /* Character and date values, laid out the
+                                 * way they're stored in the record */
+    double  number;             /* Numeric and integer values */
+} FILTER;
 
-    /* Handle failures. */
-    if(iconv_value == (size_t)-1) {
-        fprintf(stderr, "iconv failed\n");
-        switch(errno) {
-            case EILSEQ:
-                fprintf(stderr, "Invalid multibyte sequence.\n");
-                break;
-            case EINVAL:
-                fprintf(stderr, "Incomplete multibyte sequence.\n");
-                break;
-            case E2BIG:
-                fprintf(stderr, "No more room (increase size of outbuf in pgdbf.h).\n");
-                break;
-            default:
-                fprintf(stderr, "Error: %s.\n", strerror(errno));
-        }
-        exit(1);
-    }
+/* Everything about the table that's needed to format its records. This is
+ * filled in once by converttable() and only read after that, so it's safe
+ * to share between worker threads. */
+typedef struct {
+    const struct FIELDSTEP *plan; /* How to format each column */
+    size_t    plansize;         /* The number of columns in each tuple */
+    const FILTER *filters;      /* Records have to pass all of these */
+    size_t    filtercount;
+    size_t    recordlength;
+    char     *memomap;
+    size_t    memoblocksize;
+    size_t    memofilesize;
+    int       memofileisdbase3;
+    int       memomapisfile;    /* Set when memomap maps the memo file
+                                 * itself, so its pages can be dropped */
+    int       trimpadding;
+    int       numericasnumeric;
+    int       binary;           /* Write binary COPY tuples instead of text */
+} TABLEINFO;
 
-    *inputsize = outbyteslen - outbytesleft;
+/* The memos referenced by the current batch of records, and counters
+ * describing how well they could be combined into larger reads */
+typedef struct {
+    size_t  pagesize;
+    size_t  window;             /* Drop the memo pages once about this many
+                                 * bytes have been read, or 0 to keep them */
+    size_t  resident;           /* Bytes requested since they were dropped */
+    size_t  memocount;          /* Memos prefetched so far */
+    size_t  rangecount;         /* Ranges they were coalesced into */
+} MEMOPREFETCH;
 
-    return outbufstart;
-}
+/* Reads batches of records from the .dbf file. Regular files are mapped
+ * into memory and each batch points straight into the mapping. Anything
+ * that can't be mapped, like a pipe, is read with fread() into buffer. A
+ * compressed file is decompressed by a separate thread into a pipe. */
+typedef struct {
+    FILE   *file;
+    size_t  position;           /* How much of the file fread() has read */
+    char   *map;                /* NULL when reading with fread() */
+    size_t  mapsize;
+    size_t  offset;             /* Where the next batch starts */
+    size_t  advised;            /* The end of the MADV_WILLNEED window */
+    size_t  released;           /* Everything before this was dropped */
+    size_t  pagesize;
+    size_t  recordlength;
+    size_t  recordsleft;
+    size_t  batchsize;          /* The most records to return at once */
+    char   *buffer;
+#if defined(HAVE_PTHREAD)
+    DECOMPRESSOR    *decompressor;  /* NULL unless the file is compressed */
+    int              pipefd;        /* The end of the pipe it writes to */
+    pthread_t        thread;
+    pthread_mutex_t  lock;
+    int              stopping;      /* Set when no more records are needed */
+#endif
+} DBFREADER;
+
+/* A single-byte codepage that can be converted to UTF-8 with a lookup
+ * table instead of iconv() */
+typedef struct {
+    const char    *name;
+    const char    *aliases;     /* Other names for it, separated by spaces */
+    const uint8_t (*toutf8)[4]; /* Bytes 0x80 and up, as a length and up to
+                                 * three bytes of UTF-8 */
+} CODEPAGE;
+
+#include "codepages.h"
+
+/* The codepage that each value of the DBF header's language byte refers
+ * to. The names are looked up in CODEPAGES first, then passed to iconv. */
+typedef struct {
+    uint8_t     language;
+    const char *codepage;
+} LANGUAGECODEPAGE;
+
+static const LANGUAGECODEPAGE LANGUAGECODEPAGES[] = {
+    {0x01, "CP437"},            /* U.S. MS-DOS */
+    {0x02, "CP850"},            /* International MS-DOS */
+    {0x03, "CP1252"},           /* Windows ANSI */
+    {0x04, "MACINTOSH"},        /* Standard Macintosh */
+    {0x57, "CP1252"},           /* ANSI, as written by some GIS tools */
+    {0x64, "CP852"},            /* Eastern European MS-DOS */
+    {0x65, "CP866"},            /* Russian MS-DOS */
+    {0x66, "CP865"},            /* Nordic MS-DOS */
+    {0x67, "CP861"},            /* Icelandic MS-DOS */
+    {0x6A, "CP737"},            /* Greek MS-DOS */
+    {0x6B, "CP857"},            /* Turkish MS-DOS */
+    {0x78, "CP950"},            /* Traditional Chinese Windows */
+    {0x79, "CP949"},            /* Korean Windows */
+    {0x7A, "CP936"},            /* Simplified Chinese Windows */
+    {0x7B, "CP932"},            /* Japanese Windows */
+    {0x7C, "CP874"},            /* Thai Windows */
+    {0x7D, "CP1255"},           /* Hebrew Windows */
+    {0x7E, "CP1256"},           /* Arabic Windows */
+    {0xC8, "CP1250"},           /* Eastern European Windows */
+    {0xC9, "CP1251"},           /* Russian Windows */
+    {0xCA, "CP1254"},           /* Turkish Windows */
+    {0xCB, "CP1253"},           /* Greek Windows */
+    {0, NULL}
+};
+
+/* One table to be converted in batch mode */
+typedef struct {
+    char  *dbffilename;
+    char  *memofilename;        /* NULL if there isn't one */
+    char  *tablename;
+    off_t  size;                /* Of the DBF and memo files together */
+} BATCHTABLE;
+
+/* The tables to be converted in batch mode, largest first, and the next
+ * one to hand out to a worker */
+typedef struct {
+    BATCHTABLE     *tables;
+    size_t          tablecount;
+    size_t          size;       /* The number of tables allocated */
+    size_t          next;
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_t lock;
 #endif
+    STATS           stats;      /* Totals from every worker */
+} BATCH;
+
+/* One contiguous range of a table's records, written to a file of its own
+ * by --shards */
+typedef struct {
+    const char      *dbffilename;
+    const char      *baretablename;
+    const TABLEINFO *table;
+    size_t           headerlength;
+    size_t           firstrecord;
+    size_t           recordcount;
+    size_t           batchsize;
+    size_t           longestfield;
+    const char      *inputcharset;
+    size_t           memorylimit;  /* The shard's share of --max-memory */
+    int              number;
+    STATS            stats;
+} SHARD;
+
+/* One chunk of an arena's memory. The memory handed out follows the
+ * header. */
+typedef struct ARENACHUNK {
+    struct ARENACHUNK *previous; /* The chunk allocated before this one */
+    size_t  size;
+    size_t  used;
+} ARENACHUNK;
+
+/* Scratch memory that's only needed while one batch of records is being
+ * formatted. Allocations are carved out of the newest chunk. Everything
+ * allocated after a mark can be given back at once, and the largest chunk
+ * given back is kept for the next value that needs one. Resetting the
+ * arena after each batch frees every chunk but the first, so one huge
+ * value doesn't hold on to its memory for the rest of the table. */
+typedef struct {
+    ARENACHUNK *chunk;          /* The newest chunk */
+    ARENACHUNK *spare;          /* Given back since the last reset */
+    size_t      size;           /* Of all the chunks together */
+    size_t      peak;           /* The largest size so far */
+    size_t      limit;          /* 0 for no limit */
+    STATS      *stats;          /* NULL unless collecting stats */
+} ARENA;
+
+/* A point that an arena can be rolled back to */
+typedef struct {
+    ARENACHUNK *chunk;
+    size_t      used;
+} ARENAMARK;
+
+/* The private state of one record formatter. Worker threads each get their
+ * own so that they never share output buffers or iconv descriptors. */
+typedef struct {
+    OUTBUF *output;             /* Formatted records are written here */
+    OUTBUF  privateoutput;      /* The buffer output points to, unless the
+                                 * formatter shares the main output */
+    char   *outputbuffer;       /* Scratch space for short values */
+    int     binary;             /* Write strings as binary COPY values */
+    const CODEPAGE *codepage;   /* Set when converting with a table */
+    ARENA   arena;              /* Holds converted values and anything else
+                                 * needed only for the current batch */
+    STATS  *stats;              /* NULL unless collecting stats */
+    int32_t cachedjulianday;    /* The last timestamp date converted... */
+    char    cacheddate[10];     /* ...and its YYYY-MM-DD form */
+#if defined(HAVE_ICONV)
+    iconv_t conv_desc;
+#endif
+} FORMATTER;
+
+/* One step of a table's formatting plan: a column that's written to the
+ * output, where it is in each record, and the function that formats it */
+typedef struct FIELDSTEP {
+    size_t         offset;      /* From the start of the record */
+    size_t         length;
+    int            decimals;
+    char           type;
+    char           separator;   /* Written before the value, or NUL */
+    const PGFIELD *pgfield;
+    void         (*format)(FORMATTER *formatter, const TABLEINFO *table, const struct FIELDSTEP *step, const char *value);
+} FIELDSTEP;
+
+/* What "--narrow-types" learns about one column from a pass over the
+ * records' raw bytes */
+typedef struct {
+    size_t  fieldnum;
+    size_t  offset;             /* From the start of the record */
+    size_t  length;
+    char    type;
+    int     hasvalue;           /* Set once a non-blank value is seen */
+    int     integral;           /* Cleared by a value that isn't a whole
+                                 * number that fits in a BIGINT */
+    int64_t minimum;
+    int64_t maximum;
+    size_t  longest;            /* Without trailing padding */
+} COLUMNSCAN;
+
+/* The start of a fingerprint file. It's followed by one entry per record:
+ * the record's hash, then the raw bytes of its key fields. */
+typedef struct {
+    char     magic[8];
+    uint32_t byteorder;
+    uint32_t recordlength;
+    uint32_t keylength;         /* The key fields' total length */
+    uint32_t reserved;
+    uint64_t layout;            /* A hash of where the key fields are */
+} FINGERPRINTHEADER;
+
+/* Compares each record's fingerprint with the one from the last run, and
+ * writes the new fingerprints as it goes */
+typedef struct {
+    FILE            *oldfile;   /* NULL once it's been read to the end */
+    FILE            *newfile;
+    int              delta;     /* Set if there were old fingerprints */
+    const TABLEINFO *table;
+    TABLEINFO        keytable;  /* Formats a record's key columns alone */
+    size_t           keylength;
+    size_t           entrylength;
+    char            *oldentry;
+    char            *newentry;
+    char            *keyrecord; /* A record that old keys are copied into */
+    FORMATTER        keyformatter; /* Collects the old keys of the rows to
+                                    * delete in memory */
+    int              nullkeys;  /* Set if one of those keys has a NULL */
+    size_t           added;
+    size_t           changed;
+    size_t           removed;
+} FINGERPRINTS;
 
 static void exitwitherror(const char *message, const int systemerror) {
     /* Print the given error message to stderr, then exit.  If systemerror
@@ -254,272 +673,4185 @@ static void exitwitherror(const char *message, const int systemerror) {
     exit(EXIT_FAILURE);
 }
 
-static void safeprintbuf(const char *buf, const size_t inputsize, const int trimpadding) {
-    /* Print a string, insuring that it's fit for use in a tab-delimited
-     * text file */
-    char       *convbuf;
-    char       *targetbuf;
+/* Byte scanning kernels. Text values are usually long runs of ordinary
+ * characters, so these look at 16 or 32 bytes at a time to find the few
+ * spots that need attention. */
+
+static size_t scalartrimmedlength(const char *buf, const size_t length) {
+    /* Return the length of buf without any trailing spaces or NULs */
     const char *s;
-    const char *lastchar;
-    char       *t;
-    size_t     realsize = 0;
 
-    /* Shortcut for empty strings */
-    if(*buf == '\0') {
-        return;
+    for(s = buf + length; s > buf; s--) {
+        if(s[-1] != ' ' && s[-1] != '\0') {
+            break;
+        }
     }
+    return s - buf;
+}
 
-    /* Remove padding added to fixed size fields */
-    if(trimpadding) {
-        /* Find the rightmost non-space, non-null character */
-        for(s = buf + inputsize - 1; s >= buf; s--) {
-            if(*s != ' ' && *s != '\0') {
-                break;
-            }
-        }
+static size_t scalarfindescape(const char *buf, const size_t length) {
+    /* Return the offset of the first byte that COPY needs escaped, or
+     * length if there isn't one */
+    const char *s;
+    const char *end = buf + length;
 
-        /* If there aren't any non-space characters, skip the output part */
-        if(s < buf) {
-            return;
+    for(s = buf; s < end; s++) {
+        if(*s == '\\' || *s == '\n' || *s == '\r' || *s == '\t') {
+            break;
         }
     }
-    else {
-        s = buf + inputsize - 1;
+    return s - buf;
+}
+
+static const char HEXDIGITS[] = "0123456789abcdef";
+
+static void scalarhexencode(char *dest, const char *buf, const size_t length) {
+    /* Write the 2 * length lowercase hex digits of buf to dest */
+    size_t offset;
+
+    for(offset = 0; offset < length; offset++) {
+        *dest++ = HEXDIGITS[(uint8_t) buf[offset] >> 4];
+        *dest++ = HEXDIGITS[buf[offset] & 0x0F];
     }
+}
 
-    lastchar = s;
-    realsize = s - buf + 1;
-    convbuf = (char *)buf;
+static size_t scalarfindnonascii(const char *buf, const size_t length) {
+    /* Return the offset of the first byte with its high bit set, or length
+     * if they're all ASCII */
+    size_t offset;
 
-#if defined(HAVE_ICONV)
-    if(conv_desc != NULL) {
-        convbuf = convertcharset(buf, &realsize);
-        lastchar = convbuf + realsize - 1;
+    for(offset = 0; offset < length; offset++) {
+        if(buf[offset] & 0x80) {
+            break;
+        }
     }
-#endif
+    return offset;
+}
 
-    if(realsize * 2 < STATICBUFFERSIZE) {
-        targetbuf = staticbuf;
-    } else {
-        targetbuf = malloc(realsize * 2 + 1);
-        if(targetbuf == NULL) {
-            exitwitherror("Unable to malloc the escape output buffer", 1);
+#if defined(USEX86SIMD)
+__attribute__((target("sse2")))
+static size_t sse2trimmedlength(const char *buf, const size_t length) {
+    const __m128i spaces = _mm_set1_epi8(' ');
+    const __m128i nuls = _mm_setzero_si128();
+    const char   *end = buf + length;
+    __m128i       chunk;
+    unsigned int  mask;
+
+    while(end - buf >= 16) {
+        chunk = _mm_loadu_si128((const __m128i *) (end - 16));
+        mask = ~_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, spaces),
+                                               _mm_cmpeq_epi8(chunk, nuls))) & 0xFFFF;
+        if(mask) {
+            /* The highest set bit is the last byte worth keeping */
+            return end - 16 - buf + 32 - __builtin_clz(mask);
         }
+        end -= 16;
     }
+    return scalartrimmedlength(buf, end - buf);
+}
 
-    /* Re-write invalid characters to their SQL-safe alternatives */
-    t = targetbuf;
-    for(s = convbuf; s <= lastchar; s++) {
-        switch(*s) {
-        case '\\':
-            *t++ = '\\';
-            *t++ = '\\';
-            break;
-        case '\n':
-            *t++ = '\\';
-            *t++ = 'n';
-            break;
-        case '\r':
-            *t++ = '\\';
-            *t++ = 'r';
-            break;
-        case '\t':
-            *t++ = '\\';
-            *t++ = 't';
-            break;
-        default:
-            *t++ = *s;
+__attribute__((target("sse2")))
+static size_t sse2findescape(const char *buf, const size_t length) {
+    const __m128i backslashes = _mm_set1_epi8('\\');
+    const __m128i newlines = _mm_set1_epi8('\n');
+    const __m128i returns = _mm_set1_epi8('\r');
+    const __m128i tabs = _mm_set1_epi8('\t');
+    size_t        offset = 0;
+    __m128i       chunk;
+    unsigned int  mask;
+
+    for(; offset + 16 <= length; offset += 16) {
+        chunk = _mm_loadu_si128((const __m128i *) (buf + offset));
+        mask = _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, backslashes),
+                                                           _mm_cmpeq_epi8(chunk, newlines)),
+                                              _mm_or_si128(_mm_cmpeq_epi8(chunk, returns),
+                                                           _mm_cmpeq_epi8(chunk, tabs))));
+        if(mask) {
+            return offset + __builtin_ctz(mask);
         }
     }
-    *t = '\0';
+    return offset + scalarfindescape(buf + offset, length - offset);
+}
 
-    printf("%s", targetbuf);
+__attribute__((target("sse2")))
+static size_t sse2findnonascii(const char *buf, const size_t length) {
+    size_t       offset = 0;
+    unsigned int mask;
 
-#if defined(HAVE_ICONV)
-    if(conv_desc != NULL) {
-        free(convbuf);
+    for(; offset + 16 <= length; offset += 16) {
+        mask = _mm_movemask_epi8(_mm_loadu_si128((const __m128i *) (buf + offset)));
+        if(mask) {
+            return offset + __builtin_ctz(mask);
+        }
     }
-#endif
+    return offset + scalarfindnonascii(buf + offset, length - offset);
+}
+
+__attribute__((target("sse2")))
+static void sse2hexencode(char *dest, const char *buf, const size_t length) {
+    /* Split each byte into its two nibbles, put them side by side, and turn
+     * 0-9 into '0'-'9' and 10-15 into 'a'-'f' */
+    const __m128i nibblemask = _mm_set1_epi8(0x0F);
+    const __m128i nines = _mm_set1_epi8(9);
+    const __m128i zeroes = _mm_set1_epi8('0');
+    const __m128i letteroffset = _mm_set1_epi8('a' - '0' - 10);
+    size_t        offset = 0;
+    __m128i       chunk;
+    __m128i       high;
+    __m128i       low;
+    __m128i       digits;
 
-    if(targetbuf != staticbuf) {
-        free(targetbuf);
+    for(; offset + 16 <= length; offset += 16) {
+        chunk = _mm_loadu_si128((const __m128i *) (buf + offset));
+        high = _mm_and_si128(_mm_srli_epi16(chunk, 4), nibblemask);
+        low = _mm_and_si128(chunk, nibblemask);
+        digits = _mm_unpacklo_epi8(high, low);
+        digits = _mm_add_epi8(_mm_add_epi8(digits, zeroes), _mm_and_si128(_mm_cmpgt_epi8(digits, nines), letteroffset));
+        _mm_storeu_si128((__m128i *) (dest + 2 * offset), digits);
+        digits = _mm_unpackhi_epi8(high, low);
+        digits = _mm_add_epi8(_mm_add_epi8(digits, zeroes), _mm_and_si128(_mm_cmpgt_epi8(digits, nines), letteroffset));
+        _mm_storeu_si128((__m128i *) (dest + 2 * offset + 16), digits);
     }
+    scalarhexencode(dest + 2 * offset, buf + offset, length - offset);
 }
 
-int progressdots = 1;
+__attribute__((target("avx2")))
+static size_t avx2trimmedlength(const char *buf, const size_t length) {
+    const __m256i spaces = _mm256_set1_epi8(' ');
+    const __m256i nuls = _mm256_setzero_si256();
+    const char   *end = buf + length;
+    __m256i       chunk;
+    unsigned int  mask;
 
-void updateprogressbar(int percent) {
-    int newprogressdots = percent / 2;
-    for(; progressdots <= newprogressdots; progressdots++) {
-        putc('.', stderr);
-        if(progressdots && !(progressdots % 5)){
-            fprintf(stderr, "%d", progressdots * 2);
+    while(end - buf >= 32) {
+        chunk = _mm256_loadu_si256((const __m256i *) (end - 32));
+        mask = ~(unsigned int) _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, spaces),
+                                                                    _mm256_cmpeq_epi8(chunk, nuls)));
+        if(mask) {
+            return end - 32 - buf + 32 - __builtin_clz(mask);
         }
+        end -= 32;
     }
-    if(percent == 100) {
-        fprintf(stderr, "\n");
+    return sse2trimmedlength(buf, end - buf);
+}
+
+__attribute__((target("avx2")))
+static size_t avx2findescape(const char *buf, const size_t length) {
+    const __m256i backslashes = _mm256_set1_epi8('\\');
+    const __m256i newlines = _mm256_set1_epi8('\n');
+    const __m256i returns = _mm256_set1_epi8('\r');
+    const __m256i tabs = _mm256_set1_epi8('\t');
+    size_t        offset = 0;
+    __m256i       chunk;
+    unsigned int  mask;
+
+    for(; offset + 32 <= length; offset += 32) {
+        chunk = _mm256_loadu_si256((const __m256i *) (buf + offset));
+        mask = _mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, backslashes),
+                                                                    _mm256_cmpeq_epi8(chunk, newlines)),
+                                                    _mm256_or_si256(_mm256_cmpeq_epi8(chunk, returns),
+                                                                    _mm256_cmpeq_epi8(chunk, tabs))));
+        if(mask) {
+            return offset + __builtin_ctz(mask);
+        }
     }
-    fflush(stderr);
+    return offset + sse2findescape(buf + offset, length - offset);
 }
 
-/* Endian-specific code.  Define functions to convert input data to the
- * required form depending on the endianness of the host architecture. */
+__attribute__((target("avx2")))
+static size_t avx2findnonascii(const char *buf, const size_t length) {
+    size_t       offset = 0;
+    unsigned int mask;
 
-#define SWAP8BYTES(rightend, wrongendcharptr)   \
-    const char *src = wrongendcharptr + 7;      \
-    memcpy((char *) &rightend    , src--, 1);   \
-    memcpy((char *) &rightend + 1, src--, 1);   \
-    memcpy((char *) &rightend + 2, src--, 1);   \
-    memcpy((char *) &rightend + 3, src--, 1);   \
-    memcpy((char *) &rightend + 4, src--, 1);   \
-    memcpy((char *) &rightend + 5, src--, 1);   \
-    memcpy((char *) &rightend + 6, src--, 1);   \
-    memcpy((char *) &rightend + 7, src  , 1);
+    for(; offset + 32 <= length; offset += 32) {
+        mask = _mm256_movemask_epi8(_mm256_loadu_si256((const __m256i *) (buf + offset)));
+        if(mask) {
+            return offset + __builtin_ctz(mask);
+        }
+    }
+    return offset + sse2findnonascii(buf + offset, length - offset);
+}
 
-#define SWAPANDRETURN8BYTES(wrongendcharptr)   \
-    int64_t rightend;                          \
-    SWAP8BYTES(rightend, wrongendcharptr)      \
-    return rightend;
+__attribute__((target("avx2")))
+static void avx2hexencode(char *dest, const char *buf, const size_t length) {
+    /* The same as sse2hexencode(), except that AVX2 unpacks within each
+     * 16-byte lane, so the lanes have to be put back in order */
+    const __m256i nibblemask = _mm256_set1_epi8(0x0F);
+    const __m256i nines = _mm256_set1_epi8(9);
+    const __m256i zeroes = _mm256_set1_epi8('0');
+    const __m256i letteroffset = _mm256_set1_epi8('a' - '0' - 10);
+    size_t        offset = 0;
+    __m256i       chunk;
+    __m256i       high;
+    __m256i       low;
+    __m256i       first;
+    __m256i       second;
 
-#define SWAPANDRETURN4BYTES(wrongendcharptr)   \
-    const char *src = wrongendcharptr + 3;     \
-    int32_t rightend;                          \
-    memcpy((char*) &rightend    , src--, 1);   \
-    memcpy((char*) &rightend + 1, src--, 1);   \
-    memcpy((char*) &rightend + 2, src--, 1);   \
-    memcpy((char*) &rightend + 3, src  , 1);   \
-    return rightend;
+    for(; offset + 32 <= length; offset += 32) {
+        chunk = _mm256_loadu_si256((const __m256i *) (buf + offset));
+        high = _mm256_and_si256(_mm256_srli_epi16(chunk, 4), nibblemask);
+        low = _mm256_and_si256(chunk, nibblemask);
+        first = _mm256_unpacklo_epi8(high, low);
+        second = _mm256_unpackhi_epi8(high, low);
+        first = _mm256_add_epi8(_mm256_add_epi8(first, zeroes), _mm256_and_si256(_mm256_cmpgt_epi8(first, nines), letteroffset));
+        second = _mm256_add_epi8(_mm256_add_epi8(second, zeroes), _mm256_and_si256(_mm256_cmpgt_epi8(second, nines), letteroffset));
+        _mm256_storeu_si256((__m256i *) (dest + 2 * offset), _mm256_permute2x128_si256(first, second, 0x20));
+        _mm256_storeu_si256((__m256i *) (dest + 2 * offset + 32), _mm256_permute2x128_si256(first, second, 0x31));
+    }
+    sse2hexencode(dest + 2 * offset, buf + offset, length - offset);
+}
+#endif
 
-#define SWAPANDRETURN2BYTES(wrongendcharptr)   \
-    const char *src = wrongendcharptr + 1;     \
-    int16_t rightend;                          \
-    memcpy((char*) &rightend    , src--, 1);   \
-    memcpy((char*) &rightend + 1, src  , 1);   \
-    return rightend;
+/* The kernels in use, as picked by selectkernels() */
+static size_t (*trimmedlength)(const char *, const size_t) = scalartrimmedlength;
+static size_t (*findescape)(const char *, const size_t) = scalarfindescape;
+static size_t (*findnonascii)(const char *, const size_t) = scalarfindnonascii;
+static void   (*hexencode)(char *, const char *, const size_t) = scalarhexencode;
 
-/* Integer-to-integer */
+static void selectkernels(void) {
+    /* Use the fastest kernels this CPU can run. Call this once, before
+     * starting any worker threads. */
+#if defined(USEX86SIMD)
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")) {
+        trimmedlength = avx2trimmedlength;
+        findescape = avx2findescape;
+        findnonascii = avx2findnonascii;
+        hexencode = avx2hexencode;
+    } else if(__builtin_cpu_supports("sse2")) {
+        trimmedlength = sse2trimmedlength;
+        findescape = sse2findescape;
+        findnonascii = sse2findnonascii;
+        hexencode = sse2hexencode;
+    }
+#endif
+}
 
-static int64_t nativeint64_t(const int64_t rightend) {
-    /* Leave a 64-bit integer alone */
-    return rightend;
+/* Statistics for "--stats". Everything here is skipped when the STATS
+ * pointer it's given is NULL, so collecting them costs nothing otherwise. */
+
+static uint64_t monotonicns(void) {
+    /* Return a timestamp in nanoseconds from a clock that never goes
+     * backward */
+#if defined(HAVE_CLOCK_GETTIME)
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+#else
+    struct timeval now;
+
+    gettimeofday(&now, NULL);
+    return (uint64_t) now.tv_sec * 1000000000 + now.tv_usec * 1000;
+#endif
 }
 
-static int64_t swappedint64_t(const int64_t wrongend) {
-    /* Change the endianness of a 64-bit integer */
-    SWAPANDRETURN8BYTES(((char *) &wrongend))
+static uint64_t statsclock(const STATS *stats) {
+    /* Return the time a phase started, or 0 if stats aren't wanted */
+    return stats != NULL ? monotonicns() : 0;
 }
 
-static int32_t nativeint32_t(const int32_t rightend) {
-    /* Leave a 32-bit integer alone */
-    return rightend;
+static void statsphase(STATS *stats, const int phase, const uint64_t started) {
+    /* Add the time since started to one of the phase timers */
+    if(stats != NULL) {
+        stats->phasetime[phase] += monotonicns() - started;
+    }
 }
 
-static int32_t swappedint32_t(const int32_t wrongend) {
-    /* Change the endianness of a 32-bit integer */
-    SWAPANDRETURN4BYTES(((char*) &wrongend))
+static uint64_t countfield(STATS *stats, const char type, const uint64_t started) {
+    /* Charge the time since started to a field type, and return the
+     * current time so that the next field can start from there */
+    uint64_t now = monotonicns();
+
+    stats->fieldvalues[(uint8_t) type]++;
+    stats->fieldtime[(uint8_t) type] += now - started;
+    return now;
 }
 
-static int16_t nativeint16_t(const int16_t rightend) {
-    /* Leave a 16-bit integer alone */
-    return rightend;
+static void addstats(STATS *total, const STATS *stats) {
+    /* Add one set of stats to another */
+    int i;
+
+    total->tables += stats->tables;
+    total->records += stats->records;
+    total->deletedrecords += stats->deletedrecords;
+    total->filteredrecords += stats->filteredrecords;
+    total->bytesin += stats->bytesin;
+    total->bytesout += stats->bytesout;
+    total->memos += stats->memos;
+    total->memobytes += stats->memobytes;
+    total->memosprefetched += stats->memosprefetched;
+    total->memoranges += stats->memoranges;
+    total->escapes += stats->escapes;
+    total->buffergrowths += stats->buffergrowths;
+    if(stats->arenapeak > total->arenapeak) {
+        total->arenapeak = stats->arenapeak;
+    }
+    for(i = 0; i < STATPHASES; i++) {
+        total->phasetime[i] += stats->phasetime[i];
+    }
+    for(i = 0; i < 256; i++) {
+        total->fieldvalues[i] += stats->fieldvalues[i];
+        total->fieldtime[i] += stats->fieldtime[i];
+    }
 }
 
-static int16_t swappedint16_t(const int16_t wrongend) {
-    /* Change the endianness of a 16-bit integer */
-    SWAPANDRETURN2BYTES(((char*) &wrongend))
+static void writestats(FILE *file, const STATS *stats, const uint64_t elapsed) {
+    /* Print the stats as a JSON object. Phases that ran in several threads
+     * at once report the sum of their times, so they can add up to more
+     * than the elapsed time. */
+    static const char *PHASENAMES[STATPHASES] = {"header", "read", "memo_prefetch", "format", "charset_conversion", "flush"};
+    struct rusage usage;
+    const char   *separator = "";
+    int           i;
+
+    memset(&usage, 0, sizeof(usage));
+    getrusage(RUSAGE_SELF, &usage);
+    fprintf(file, "{\"elapsed_seconds\": %.6f, \"tables\": %"PRIu64", \"records\": %"PRIu64
+            ", \"deleted_records\": %"PRIu64", \"filtered_records\": %"PRIu64", \"bytes_in\": %"PRIu64
+            ", \"bytes_out\": %"PRIu64", \"memos\": %"PRIu64", \"memo_bytes\": %"PRIu64
+            ", \"memos_prefetched\": %"PRIu64", \"memo_ranges\": %"PRIu64", \"escapes\": %"PRIu64
+            ", \"buffer_growths\": %"PRIu64", \"arena_peak_bytes\": %"PRIu64
+            ", \"major_page_faults\": %ld, \"minor_page_faults\": %ld",
+            elapsed / 1e9, stats->tables, stats->records, stats->deletedrecords, stats->filteredrecords,
+            stats->bytesin, stats->bytesout,
+            stats->memos, stats->memobytes, stats->memosprefetched, stats->memoranges, stats->escapes, stats->buffergrowths, stats->arenapeak,
+            (long) usage.ru_majflt, (long) usage.ru_minflt);
+    fprintf(file, ", \"phases\": {");
+    for(i = 0; i < STATPHASES; i++) {
+        fprintf(file, "%s\"%s\": %.6f", i ? ", " : "", PHASENAMES[i], stats->phasetime[i] / 1e9);
+    }
+    fprintf(file, "}, \"fields\": {");
+    for(i = 0; i < 256; i++) {
+        if(stats->fieldvalues[i]) {
+            fprintf(file, isalnum(i) ? "%s\"%c\"" : "%s\"0x%02X\"", separator, i);
+            fprintf(file, ": {\"values\": %"PRIu64", \"seconds\": %.6f}", stats->fieldvalues[i], stats->fieldtime[i] / 1e9);
+            separator = ", ";
+        }
+    }
+    fprintf(file, "}}\n");
 }
 
-/* String-to-integer */
+/* Output buffers */
 
-static int64_t snativeint64_t(const char *buf) {
-    /* Interpret the first 8 bytes of buf as a 64-bit int */
-    int64_t output;
-    memcpy(&output, buf, 8);
-    return output;
+static void writeall(const int fd, const char *buf, const size_t length) {
+    /* Write the entire buffer, retrying after short writes */
+    const char *s = buf;
+    ssize_t     written;
+
+    while(s < buf + length) {
+        written = write(fd, s, buf + length - s);
+        if(written == -1) {
+            if(errno == EINTR) {
+                continue;
+            }
+            exitwitherror("Unable to write the output", 1);
+        }
+        s += written;
+    }
 }
 
-static int64_t sswappedint64_t(const char *buf) {
-    /* The byte-swapped version of snativeint64_t */
-    SWAPANDRETURN8BYTES(buf)
+static void fdsink(OUTBUF *outbuf, const char *buf, const size_t length) {
+    /* Send output to the buffer's file descriptor */
+    writeall(outbuf->fd, buf, length);
 }
 
-static int32_t snativeint32_t(const char *buf) {
-    /* Interpret the first 4 bytes of buf as a 32-bit int */
-    int32_t output;
-    memcpy(&output, buf, 4);
-    return output;
+static void initoutbuf(OUTBUF *outbuf, const int fd, const size_t flushsize) {
+    /* Prepare an empty output buffer. Pass -1 as fd to keep everything in
+     * memory. */
+    outbuf->fd = fd;
+    outbuf->sink = fd == -1 ? NULL : fdsink;
+    outbuf->sinkarg = NULL;
+    outbuf->stats = NULL;
+    outbuf->flushsize = flushsize;
+    outbuf->length = 0;
+    outbuf->size = flushsize;
+    outbuf->data = malloc(outbuf->size);
+    if(outbuf->data == NULL) {
+        exitwitherror("Unable to malloc an output buffer", 1);
+    }
 }
 
-static int32_t sswappedint32_t(const char *buf) {
-    /* The byte-swapped version of snativeint32_t */
-    SWAPANDRETURN4BYTES(buf)
+static size_t parsesize(const char *value) {
+    /* Convert a size like "65536", "64K", "16M", or "1G" to a number of
+     * bytes. Returns 0 if the value can't be parsed. */
+    char   *suffix;
+    double  number;
+
+    number = strtod(value, &suffix);
+    if(suffix == value || number <= 0) {
+        return 0;
+    }
+    switch(*suffix) {
+    case 'G':
+    case 'g':
+        number *= 1024;
+        /* Fall through */
+    case 'M':
+    case 'm':
+        number *= 1024;
+        /* Fall through */
+    case 'K':
+    case 'k':
+        number *= 1024;
+        suffix++;
+        break;
+    }
+    if(*suffix != '\0' || number < 1) {
+        return 0;
+    }
+    return (size_t) number;
 }
 
-static int16_t snativeint16_t(const char *buf) {
-    /* Interpret the first 2 bytes of buf as a 16-bit int */
-    int16_t output;
-    memcpy(&output, buf, 2);
-    return output;
+static int parsecount(const char *value, size_t *count) {
+    /* Convert a non-negative whole number like a record number. Returns 0
+     * if the value can't be parsed. */
+    char          *end;
+    unsigned long  number;
+
+    if(!isdigit((unsigned char) *value)) {
+        return 0;
+    }
+    errno = 0;
+    number = strtoul(value, &end, 10);
+    if(*end != '\0' || errno) {
+        return 0;
+    }
+    *count = number;
+    return 1;
 }
 
-static int16_t sswappedint16_t(const char *buf) {
-    /* The byte-swapped version of snativeint16_t */
-    SWAPANDRETURN2BYTES(buf)
+static void outbufsend(OUTBUF *outbuf, const char *buf, const size_t length) {
+    /* Hand bytes to the buffer's sink, timing how long it takes */
+    uint64_t started = statsclock(outbuf->stats);
+
+    outbuf->sink(outbuf, buf, length);
+    if(outbuf->stats != NULL) {
+        statsphase(outbuf->stats, STATFLUSH, started);
+        outbuf->stats->bytesout += length;
+    }
 }
 
-#ifdef WORDS_BIGENDIAN
-#define bigint64_t     nativeint64_t
-#define littleint64_t  swappedint64_t
+static void outbufflush(OUTBUF *outbuf) {
+    /* Hand everything in the buffer to its sink */
+    if(outbuf->sink == NULL) {
+        return;
+    }
+    if(outbuf->length) {
+        outbufsend(outbuf, outbuf->data, outbuf->length);
+    }
+    outbuf->length = 0;
 
-#define bigint32_t     nativeint32_t
-#define littleint32_t  swappedint32_t
+    /* Give back memory that was added to hold a single huge value */
+    if(outbuf->size > outbuf->flushsize * 2) {
+        free(outbuf->data);
+        outbuf->size = outbuf->flushsize;
+        outbuf->data = malloc(outbuf->size);
+        if(outbuf->data == NULL) {
+            exitwitherror("Unable to malloc an output buffer", 1);
+        }
+    }
+}
 
-#define bigint16_t     nativeint16_t
-#define littleint16_t  swappedint16_t
+static void freeoutbuf(OUTBUF *outbuf) {
+    /* Flush and release an output buffer */
+    outbufflush(outbuf);
+    free(outbuf->data);
+    outbuf->data = NULL;
+}
 
-#define sbigint64_t    snativeint64_t
-#define slittleint64_t sswappedint64_t
+static void retargetoutbuf(OUTBUF *outbuf, const int fd) {
+    /* Flush an output buffer and point it at a different file descriptor,
+     * keeping its memory for reuse. Pass -1 as fd to keep everything in
+     * memory. */
+    outbufflush(outbuf);
+    outbuf->fd = fd;
+    outbuf->sink = fd == -1 ? NULL : fdsink;
+}
 
-#define sbigint32_t    snativeint32_t
-#define slittleint32_t sswappedint32_t
+static char *outbufreserve(OUTBUF *outbuf, const size_t needed) {
+    /* Make room for at least the given number of bytes at the end of the
+     * buffer and return a pointer to that space. The caller is responsible
+     * for adding however many bytes it actually used to outbuf->length. */
+    size_t newsize;
+    char  *newdata;
 
-#define sbigint16_t    snativeint16_t
-#define slittleint16_t sswappedint16_t
+    if(outbuf->size - outbuf->length >= needed) {
+        return outbuf->data + outbuf->length;
+    }
+    if(outbuf->sink != NULL && outbuf->length) {
+        outbufflush(outbuf);
+        if(outbuf->size - outbuf->length >= needed) {
+            return outbuf->data + outbuf->length;
+        }
+    }
+    if(outbuf->stats != NULL) {
+        outbuf->stats->buffergrowths++;
+    }
+    newsize = outbuf->size * 2;
+    if(newsize < outbuf->length + needed) {
+        newsize = outbuf->length + needed;
+    }
+    newdata = realloc(outbuf->data, newsize);
+    if(newdata == NULL) {
+        exitwitherror("Unable to grow an output buffer", 1);
+    }
+    outbuf->data = newdata;
+    outbuf->size = newsize;
+    return outbuf->data + outbuf->length;
+}
 
-static double sdouble(const char *buf) {
-    /* Doubles are stored as 64-bit little-endian, so swap ends */
+static void outbufcommit(OUTBUF *outbuf, const size_t used) {
+    /* Account for bytes added after outbufreserve(), then flush if the
+     * buffer is full enough */
+    outbuf->length += used;
+    if(outbuf->length >= outbuf->flushsize && outbuf->sink != NULL) {
+        outbufflush(outbuf);
+    }
+}
+
+static void outbufwrite(OUTBUF *outbuf, const char *buf, const size_t length) {
+    /* Append raw bytes */
+    if(outbuf->sink != NULL && length >= outbuf->flushsize) {
+        /* Don't bother copying big blocks. Just write them. */
+        outbufflush(outbuf);
+        outbufsend(outbuf, buf, length);
+        return;
+    }
+    memcpy(outbufreserve(outbuf, length), buf, length);
+    outbufcommit(outbuf, length);
+}
+
+static void outbufputc(OUTBUF *outbuf, const char c) {
+    /* Append one byte, such as a field separator */
+    if(outbuf->length == outbuf->size) {
+        outbufreserve(outbuf, 1);
+    }
+    outbuf->data[outbuf->length++] = c;
+    if(outbuf->length >= outbuf->flushsize && outbuf->sink != NULL) {
+        outbufflush(outbuf);
+    }
+}
+
+/* "00" through "99", so that integers can be written two digits at a
+ * time */
+static const char DIGITPAIRS[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static void writedigitpair(char *t, const int value) {
+    /* Write a number from 0 to 99 as exactly two digits */
+    memcpy(t, DIGITPAIRS + 2 * value, 2);
+}
+
+static char *writeuint64(char *end, uint64_t value) {
+    /* Write an unsigned integer so that it ends just before end, and return
+     * where it starts */
+    while(value >= 100) {
+        end -= 2;
+        writedigitpair(end, value % 100);
+        value /= 100;
+    }
+    if(value >= 10) {
+        end -= 2;
+        writedigitpair(end, value);
+    } else {
+        *--end = '0' + value;
+    }
+    return end;
+}
+
+static void outbufint(OUTBUF *outbuf, const int64_t value) {
+    /* Append a decimal integer */
+    char     digits[20];
+    char    *s;
+    char    *t;
+
+    /* Negate as unsigned so that INT64_MIN works */
+    s = writeuint64(digits + sizeof(digits), value < 0 ? -(uint64_t) value : (uint64_t) value);
+    t = outbufreserve(outbuf, sizeof(digits) + 1);
+    if(value < 0) {
+        *t++ = '-';
+    }
+    memcpy(t, s, digits + sizeof(digits) - s);
+    outbufcommit(outbuf, (value < 0) + (digits + sizeof(digits) - s));
+}
+
+static void outbufprintf(OUTBUF *outbuf, const char *format, ...) {
+    /* Append printf()-formatted text */
+    va_list ap;
+    int     length;
+    size_t  available;
+    char   *t;
+
+    /* Most things fit in whatever space is left. Try that first, and only
+     * format a second time if it didn't. */
+    t = outbufreserve(outbuf, 64);
+    available = outbuf->size - outbuf->length;
+    va_start(ap, format);
+    length = vsnprintf(t, available, format, ap);
+    va_end(ap);
+    if(length < 0) {
+        exitwitherror("Unable to format the output", 1);
+    }
+    if((size_t) length >= available) {
+        t = outbufreserve(outbuf, length + 1);
+        va_start(ap, format);
+        vsnprintf(t, length + 1, format, ap);
+        va_end(ap);
+    }
+    outbufcommit(outbuf, length);
+}
+
+static void outbufcurrency(OUTBUF *outbuf, const int64_t value) {
+    /* Append a currency value, which is stored as a count of
+     * ten-thousandths, with four decimal places */
+    char     digits[20];
+    char    *s;
+    char    *t;
+    char    *start;
+    uint64_t magnitude = value < 0 ? -(uint64_t) value : (uint64_t) value;
+
+    s = writeuint64(digits + sizeof(digits), magnitude / 10000);
+    start = t = outbufreserve(outbuf, sizeof(digits) + 6);
+    if(value < 0) {
+        *t++ = '-';
+    }
+    memcpy(t, s, digits + sizeof(digits) - s);
+    t += digits + sizeof(digits) - s;
+    *t++ = '.';
+    writedigitpair(t, magnitude % 10000 / 100);
+    writedigitpair(t + 2, magnitude % 100);
+    outbufcommit(outbuf, t + 4 - start);
+}
+
+/* Powers of ten that fit in 64 bits */
+static const uint64_t POWERSOF10[] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL,
+    1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+    100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL,
+    1000000000000000000ULL, 10000000000000000000ULL
+};
+
+static void outbuffixed(OUTBUF *outbuf, const double value, const int decimals) {
+    /* Append a double rounded to the given number of decimal places,
+     * exactly as printf("%.*f") would write it. A double is an integer
+     * mantissa times a power of two, so multiplying the mantissa by
+     * 10^decimals and shifting it right gives the digits, with the bits
+     * shifted out deciding the rounding. printf rounds the exact value
+     * half to even, and so does this. Numbers too large or precise for
+     * 128-bit arithmetic are left to printf. */
+#if defined(__SIZEOF_INT128__)
     union {
-        int64_t asint64;
-        double  asdouble;
-    } inttodouble;
+        uint64_t asbits;
+        double   asdouble;
+    } doubletobits;
+    unsigned __int128 scaled;
+    unsigned __int128 remainder;
+    unsigned __int128 half;
+    uint64_t mantissa;
+    int      exponent;
+    int      negative;
+    char     digits[48];
+    char    *end = digits + sizeof(digits);
+    char    *s;
+    char    *t;
+    char    *start;
+    size_t   digitcount;
 
-    SWAP8BYTES(inttodouble.asint64, buf)
-    return inttodouble.asdouble;
+    doubletobits.asdouble = value;
+    negative = doubletobits.asbits >> 63;
+    exponent = (doubletobits.asbits >> 52) & 0x7FF;
+    mantissa = doubletobits.asbits & 0xFFFFFFFFFFFFFULL;
+    if(exponent) {
+        mantissa |= 1ULL << 52;
+        exponent -= 1075;
+    } else {
+        exponent = -1074;
+    }
+
+    /* Infinities, NaNs, and anything of 2^63 or more go to printf, as do
+     * more decimals than a 64-bit power of ten can hold */
+    if(exponent < 11 && decimals >= 0 && decimals <= 19) {
+        if(exponent >= 0) {
+            scaled = (unsigned __int128) (mantissa << exponent) * POWERSOF10[decimals];
+        } else {
+            scaled = (unsigned __int128) mantissa * POWERSOF10[decimals];
+            if(-exponent > 117) {
+                /* scaled is less than 2^117, so less than half of
+                 * 2^-exponent, and rounds to zero */
+                scaled = 0;
+            } else {
+                remainder = scaled & (((unsigned __int128) 1 << -exponent) - 1);
+                half = (unsigned __int128) 1 << (-exponent - 1);
+                scaled >>= -exponent;
+                if(remainder > half || (remainder == half && (scaled & 1))) {
+                    scaled++;
+                }
+            }
+        }
+
+        /* Write the digits, with at least one before the decimal point */
+        if(scaled >= POWERSOF10[19]) {
+            s = writeuint64(end, (uint64_t) (scaled % POWERSOF10[19]));
+            while(end - s < 19) {
+                *--s = '0';
+            }
+            s = writeuint64(s, (uint64_t) (scaled / POWERSOF10[19]));
+        } else {
+            s = writeuint64(end, (uint64_t) scaled);
+        }
+        while(end - s < decimals + 1) {
+            *--s = '0';
+        }
+
+        digitcount = end - s;
+        start = t = outbufreserve(outbuf, digitcount + 2);
+        if(negative) {
+            *t++ = '-';
+        }
+        memcpy(t, s, digitcount - decimals);
+        t += digitcount - decimals;
+        if(decimals) {
+            *t++ = '.';
+            memcpy(t, end - decimals, decimals);
+            t += decimals;
+        }
+        outbufcommit(outbuf, t - start);
+        return;
+    }
+#endif
+    outbufprintf(outbuf, "%.*f", decimals, value);
+}
+
+static void outbufescaped(OUTBUF *outbuf, const char *buf, const size_t length) {
+    /* Append a string, re-writing characters that are special in COPY's
+     * text format to their escaped equivalents */
+    const char *s;
+    const char *end = buf + length;
+    char       *t;
+    char       *start;
+    size_t      run;
+
+    /* Each input byte becomes at most two output bytes */
+    start = t = outbufreserve(outbuf, length * 2);
+    for(s = buf; s < end; s++) {
+        /* Copy everything up to the next special character in one go */
+        run = findescape(s, end - s);
+        memcpy(t, s, run);
+        t += run;
+        s += run;
+        if(s == end) {
+            break;
+        }
+        switch(*s) {
+        case '\\':
+            *t++ = '\\';
+            *t++ = '\\';
+            break;
+        case '\n':
+            *t++ = '\\';
+            *t++ = 'n';
+            break;
+        case '\r':
+            *t++ = '\\';
+            *t++ = 'r';
+            break;
+        case '\t':
+            *t++ = '\\';
+            *t++ = 't';
+            break;
+        default:
+            *t++ = *s;
+        }
+    }
+    /* Every escape adds exactly one byte */
+    if(outbuf->stats != NULL) {
+        outbuf->stats->escapes += (t - start) - length;
+    }
+    outbufcommit(outbuf, t - start);
+}
+
+static void outbufhex(OUTBUF *outbuf, const char *buf, const size_t length) {
+    /* Append the bytes as hex digits, a piece at a time so that a huge
+     * value doesn't need a buffer twice its size */
+    size_t offset;
+    size_t piece;
+
+    for(offset = 0; offset < length; offset += piece) {
+        piece = length - offset < VALUEPIECESIZE ? length - offset : VALUEPIECESIZE;
+        hexencode(outbufreserve(outbuf, piece * 2), buf + offset, piece);
+        outbufcommit(outbuf, piece * 2);
+    }
+}
+
+static void outbufnetint16(OUTBUF *outbuf, const int16_t value) {
+    /* Append a 16-bit integer in network byte order */
+    char *t = outbufreserve(outbuf, 2);
+    t[0] = (char) ((uint16_t) value >> 8);
+    t[1] = (char) value;
+    outbufcommit(outbuf, 2);
+}
+
+static void outbufnetint32(OUTBUF *outbuf, const int32_t value) {
+    /* Append a 32-bit integer in network byte order */
+    char *t = outbufreserve(outbuf, 4);
+    t[0] = (char) ((uint32_t) value >> 24);
+    t[1] = (char) ((uint32_t) value >> 16);
+    t[2] = (char) ((uint32_t) value >> 8);
+    t[3] = (char) value;
+    outbufcommit(outbuf, 4);
+}
+
+static void outbufnetint64(OUTBUF *outbuf, const int64_t value) {
+    /* Append a 64-bit integer in network byte order */
+    outbufnetint32(outbuf, (int32_t) ((uint64_t) value >> 32));
+    outbufnetint32(outbuf, (int32_t) value);
+}
+
+static void outbufquoted(OUTBUF *outbuf, const char *s) {
+    /* Append a string as a single-quoted SQL literal */
+    outbufputc(outbuf, '\'');
+    for(; *s; s++) {
+        if(*s == '\'') {
+            outbufputc(outbuf, '\'');
+        }
+        outbufputc(outbuf, *s);
+    }
+    outbufputc(outbuf, '\'');
+}
+
+/* Compressed output */
+
+static void compressblock(COMPRESSOR *compressor, const char *data, const size_t length, const int last) {
+    /* Compress a block and write the result. After the last block, the
+     * compressed stream is ended. */
+#if defined(HAVE_ZSTD)
+    ZSTD_inBuffer  input;
+    ZSTD_outBuffer output;
+    size_t         remaining;
+#endif
+#if defined(HAVE_ZLIB)
+    int            status;
+#endif
+
+    switch(compressor->method) {
+#if defined(HAVE_ZSTD)
+    case COMPRESSZSTD:
+        input.src = data;
+        input.size = length;
+        input.pos = 0;
+        do {
+            output.dst = compressor->compressed;
+            output.size = compressor->compressedsize;
+            output.pos = 0;
+            remaining = ZSTD_compressStream2(compressor->zstd, &output, &input, last ? ZSTD_e_end : ZSTD_e_continue);
+            if(ZSTD_isError(remaining)) {
+                fprintf(stderr, "Unable to compress the output: %s\n", ZSTD_getErrorName(remaining));
+                exit(EXIT_FAILURE);
+            }
+            writeall(compressor->fd, compressor->compressed, output.pos);
+        } while(last ? remaining != 0 : input.pos < input.size);
+        break;
+#endif
+#if defined(HAVE_ZLIB)
+    case COMPRESSGZIP:
+        compressor->gzip.next_in = (Bytef *) data;
+        compressor->gzip.avail_in = length;
+        do {
+            compressor->gzip.next_out = (Bytef *) compressor->compressed;
+            compressor->gzip.avail_out = compressor->compressedsize;
+            status = deflate(&compressor->gzip, last ? Z_FINISH : Z_NO_FLUSH);
+            if(status == Z_STREAM_ERROR) {
+                exitwitherror("Unable to compress the output", 0);
+            }
+            writeall(compressor->fd, compressor->compressed, compressor->compressedsize - compressor->gzip.avail_out);
+        } while(last ? status != Z_STREAM_END : compressor->gzip.avail_in > 0);
+        break;
+#endif
+    }
+}
+
+#if defined(HAVE_PTHREAD)
+static void *compressthread(void *arg) {
+    /* Compress each block as it's handed over, until there are no more */
+    COMPRESSOR *compressor = (COMPRESSOR *) arg;
+    int         block;
+
+    pthread_mutex_lock(&compressor->lock);
+    for(;;) {
+        while(!compressor->pending && !compressor->finished) {
+            pthread_cond_wait(&compressor->changed, &compressor->lock);
+        }
+        if(!compressor->pending) {
+            break;
+        }
+        /* The block that isn't being filled is the one to compress */
+        block = !compressor->filling;
+        pthread_mutex_unlock(&compressor->lock);
+        compressblock(compressor, compressor->blocks[block], compressor->lengths[block], 0);
+        pthread_mutex_lock(&compressor->lock);
+        compressor->pending = 0;
+        pthread_cond_signal(&compressor->changed);
+    }
+    pthread_mutex_unlock(&compressor->lock);
+    return NULL;
 }
+#endif
+
+static void submitblock(COMPRESSOR *compressor) {
+    /* Hand the block being filled to the compression thread and start
+     * filling the other one, once the thread is done with it */
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_lock(&compressor->lock);
+    while(compressor->pending) {
+        pthread_cond_wait(&compressor->changed, &compressor->lock);
+    }
+    compressor->filling = !compressor->filling;
+    compressor->lengths[compressor->filling] = 0;
+    compressor->pending = 1;
+    pthread_cond_signal(&compressor->changed);
+    pthread_mutex_unlock(&compressor->lock);
 #else
-#define bigint64_t     swappedint64_t
-#define littleint64_t  nativeint64_t
+    compressblock(compressor, compressor->blocks[compressor->filling], compressor->lengths[compressor->filling], 0);
+    compressor->lengths[compressor->filling] = 0;
+#endif
+}
 
-#define bigint32_t     swappedint32_t
-#define littleint32_t  nativeint32_t
+static void compresssink(OUTBUF *outbuf, const char *buf, const size_t length) {
+    /* Add output to the block being filled, handing it off once it's big
+     * enough */
+    COMPRESSOR *compressor = (COMPRESSOR *) outbuf->sinkarg;
+    int         block = compressor->filling;
 
-#define bigint16_t     swappedint16_t
-#define littleint16_t  nativeint16_t
+    if(compressor->lengths[block] + length > compressor->sizes[block]) {
+        compressor->sizes[block] = compressor->lengths[block] + length;
+        compressor->blocks[block] = realloc(compressor->blocks[block], compressor->sizes[block]);
+        if(compressor->blocks[block] == NULL) {
+            exitwitherror("Unable to grow a compression block", 1);
+        }
+    }
+    memcpy(compressor->blocks[block] + compressor->lengths[block], buf, length);
+    compressor->lengths[block] += length;
+    if(compressor->lengths[block] >= COMPRESSBLOCKSIZE) {
+        submitblock(compressor);
+    }
+}
 
-#define sbigint64_t    sswappedint64_t
-#define slittleint64_t snativeint64_t
+static void compressoutbuf(OUTBUF *outbuf, COMPRESSOR *compressor, const int method, const int level, const int threads) {
+    /* Compress everything written to outbuf from now on. level is 0 for
+     * the method's default. threads is the number of extra threads that
+     * zstd may use, and is ignored by gzip. */
+    int i;
 
-#define sbigint32_t    sswappedint32_t
-#define slittleint32_t snativeint32_t
+    memset(compressor, 0, sizeof(COMPRESSOR));
+    compressor->method = method;
+    compressor->fd = outbuf->fd;
+    for(i = 0; i < 2; i++) {
+        compressor->sizes[i] = COMPRESSBLOCKSIZE + outbuf->flushsize;
+        compressor->blocks[i] = malloc(compressor->sizes[i]);
+        if(compressor->blocks[i] == NULL) {
+            exitwitherror("Unable to malloc the compression blocks", 1);
+        }
+    }
 
-#define sbigint16_t    sswappedint16_t
-#define slittleint16_t snativeint16_t
+    switch(method) {
+#if defined(HAVE_ZSTD)
+    case COMPRESSZSTD:
+        compressor->compressedsize = ZSTD_CStreamOutSize();
+        compressor->zstd = ZSTD_createCCtx();
+        if(compressor->zstd == NULL) {
+            exitwitherror("Unable to start zstd", 0);
+        }
+        if(level) {
+            ZSTD_CCtx_setParameter(compressor->zstd, ZSTD_c_compressionLevel, level);
+        }
+        if(threads && ZSTD_isError(ZSTD_CCtx_setParameter(compressor->zstd, ZSTD_c_nbWorkers, threads))) {
+            exitwitherror("This copy of zstd can't compress with multiple threads", 0);
+        }
+        break;
+#endif
+#if defined(HAVE_ZLIB)
+    case COMPRESSGZIP:
+        compressor->compressedsize = COMPRESSBLOCKSIZE;
+        /* Adding 16 to the window size asks for a gzip header */
+        if(deflateInit2(&compressor->gzip, level ? level : Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                        Z_DEFAULT_STRATEGY) != Z_OK) {
+            exitwitherror("Unable to start zlib", 0);
+        }
+        break;
+#endif
+    default:
+        exitwitherror("That compression method isn't available", 0);
+    }
+    compressor->compressed = malloc(compressor->compressedsize);
+    if(compressor->compressed == NULL) {
+        exitwitherror("Unable to malloc the compression buffer", 1);
+    }
 
-static double sdouble(const char *buf) {
-    /* Interpret the first 8 bytes of buf as a double */
-    double output;
-    memcpy(&output, buf, 8);
-    return output;
+#if defined(HAVE_PTHREAD)
+    if(pthread_mutex_init(&compressor->lock, NULL) || pthread_cond_init(&compressor->changed, NULL) ||
+       pthread_create(&compressor->thread, NULL, compressthread, compressor)) {
+        exitwitherror("Unable to start the compression thread", 0);
+    }
+#endif
+    outbufflush(outbuf);
+    outbuf->sink = compresssink;
+    outbuf->sinkarg = compressor;
+}
+
+static void finishcompressor(OUTBUF *outbuf, COMPRESSOR *compressor) {
+    /* Compress whatever is left in outbuf, end the compressed stream, and
+     * send outbuf's output straight to its file descriptor again */
+    int i;
+
+    outbufflush(outbuf);
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_lock(&compressor->lock);
+    while(compressor->pending) {
+        pthread_cond_wait(&compressor->changed, &compressor->lock);
+    }
+    compressor->finished = 1;
+    pthread_cond_signal(&compressor->changed);
+    pthread_mutex_unlock(&compressor->lock);
+    if(pthread_join(compressor->thread, NULL)) {
+        exitwitherror("Unable to join the compression thread", 0);
+    }
+    pthread_mutex_destroy(&compressor->lock);
+    pthread_cond_destroy(&compressor->changed);
+#endif
+    compressblock(compressor, compressor->blocks[compressor->filling], compressor->lengths[compressor->filling], 1);
+
+    switch(compressor->method) {
+#if defined(HAVE_ZSTD)
+    case COMPRESSZSTD:
+        ZSTD_freeCCtx(compressor->zstd);
+        break;
+#endif
+#if defined(HAVE_ZLIB)
+    case COMPRESSGZIP:
+        deflateEnd(&compressor->gzip);
+        break;
+#endif
+    }
+    for(i = 0; i < 2; i++) {
+        free(compressor->blocks[i]);
+    }
+    free(compressor->compressed);
+    outbuf->sink = outbuf->fd == -1 ? NULL : fdsink;
+    outbuf->sinkarg = NULL;
+}
+
+/* Compressed input */
+
+static int compressionmethod(const char *filename) {
+    /* Return how a file is compressed, judging by its name */
+    size_t length = strlen(filename);
+
+    if(length > 4 && !strcasecmp(filename + length - 4, ".zst")) {
+        return COMPRESSZSTD;
+    }
+    if(length > 3 && !strcasecmp(filename + length - 3, ".gz")) {
+        return COMPRESSGZIP;
+    }
+    return COMPRESSNONE;
+}
+
+static void initdecompressor(DECOMPRESSOR *decompressor, const int method, const int fd) {
+    /* Prepare to read the open file fd, decompressing it with method */
+    memset(decompressor, 0, sizeof(DECOMPRESSOR));
+    decompressor->method = method;
+    decompressor->fd = fd;
+    switch(method) {
+    case COMPRESSNONE:
+        return;
+#if defined(HAVE_ZSTD)
+    case COMPRESSZSTD:
+        decompressor->inputsize = ZSTD_DStreamInSize();
+        decompressor->zstd = ZSTD_createDCtx();
+        if(decompressor->zstd == NULL) {
+            exitwitherror("Unable to start zstd", 0);
+        }
+        break;
+#endif
+#if defined(HAVE_ZLIB)
+    case COMPRESSGZIP:
+        decompressor->inputsize = DECOMPRESSCHUNKSIZE;
+        /* Adding 32 to the window size accepts a gzip or zlib header */
+        if(inflateInit2(&decompressor->gzip, 15 + 32) != Z_OK) {
+            exitwitherror("Unable to start zlib", 0);
+        }
+        break;
+#endif
+    default:
+        exitwitherror("This copy of pgdbf can't read files compressed that way", 0);
+    }
+    decompressor->input = malloc(decompressor->inputsize);
+    if(decompressor->input == NULL) {
+        exitwitherror("Unable to malloc the decompression buffer", 1);
+    }
+}
+
+static size_t fillinput(DECOMPRESSOR *decompressor) {
+    /* Read the next piece of the compressed file and return its length, or
+     * 0 at the end of the file */
+    ssize_t length;
+
+    do {
+        length = read(decompressor->fd, decompressor->input, decompressor->inputsize);
+    } while(length == -1 && errno == EINTR);
+    if(length == -1) {
+        exitwitherror("Unable to read a compressed file", 1);
+    }
+    return length;
 }
 
+static size_t decompressread(DECOMPRESSOR *decompressor, char *buf, const size_t size) {
+    /* Decompress up to size bytes into buf and return how many there were,
+     * or 0 at the end of the file */
+    ssize_t        length;
+#if defined(HAVE_ZSTD)
+    ZSTD_outBuffer output;
+    size_t         status;
+#endif
+#if defined(HAVE_ZLIB)
+    int            gzipstatus;
+#endif
+
+    switch(decompressor->method) {
+    case COMPRESSNONE:
+        do {
+            length = read(decompressor->fd, buf, size);
+        } while(length == -1 && errno == EINTR);
+        if(length == -1) {
+            exitwitherror("Unable to read a file", 1);
+        }
+        return length;
+#if defined(HAVE_ZSTD)
+    case COMPRESSZSTD:
+        output.dst = buf;
+        output.size = size;
+        output.pos = 0;
+        for(;;) {
+            if(decompressor->zstdinput.pos == decompressor->zstdinput.size && !decompressor->full) {
+                decompressor->zstdinput.src = decompressor->input;
+                decompressor->zstdinput.size = fillinput(decompressor);
+                decompressor->zstdinput.pos = 0;
+                if(!decompressor->zstdinput.size) {
+                    if(!decompressor->ended) {
+                        exitwitherror("A zstd file ended in the middle of a frame", 0);
+                    }
+                    return 0;
+                }
+            }
+            status = ZSTD_decompressStream(decompressor->zstd, &output, &decompressor->zstdinput);
+            if(ZSTD_isError(status)) {
+                fprintf(stderr, "Unable to decompress a zstd file: %s\n", ZSTD_getErrorName(status));
+                exit(EXIT_FAILURE);
+            }
+            /* A status of 0 means a frame was completed and flushed. More
+             * frames may follow it. */
+            decompressor->ended = !status;
+            decompressor->full = output.pos == output.size && !decompressor->ended;
+            if(output.pos) {
+                return output.pos;
+            }
+        }
+#endif
+#if defined(HAVE_ZLIB)
+    case COMPRESSGZIP:
+        decompressor->gzip.next_out = (Bytef *) buf;
+        decompressor->gzip.avail_out = size;
+        for(;;) {
+            if(!decompressor->gzip.avail_in && !decompressor->full) {
+                decompressor->gzip.next_in = (Bytef *) decompressor->input;
+                decompressor->gzip.avail_in = fillinput(decompressor);
+                if(!decompressor->gzip.avail_in) {
+                    if(!decompressor->ended) {
+                        exitwitherror("A gzip file ended too soon", 0);
+                    }
+                    return 0;
+                }
+            }
+            if(decompressor->ended) {
+                /* Another gzip member follows the last one */
+                if(inflateReset(&decompressor->gzip) != Z_OK) {
+                    exitwitherror("Unable to restart zlib", 0);
+                }
+                decompressor->ended = 0;
+            }
+            gzipstatus = inflate(&decompressor->gzip, Z_NO_FLUSH);
+            if(gzipstatus == Z_STREAM_END) {
+                decompressor->ended = 1;
+            } else if(gzipstatus != Z_OK && gzipstatus != Z_BUF_ERROR) {
+                fprintf(stderr, "Unable to decompress a gzip file: %s\n",
+                        decompressor->gzip.msg != NULL ? decompressor->gzip.msg : "invalid data");
+                exit(EXIT_FAILURE);
+            }
+            /* A member that ended exactly at the end of buf has nothing
+             * more to give */
+            decompressor->full = !decompressor->gzip.avail_out && !decompressor->ended;
+            if(decompressor->gzip.avail_out < size) {
+                return size - decompressor->gzip.avail_out;
+            }
+        }
+#endif
+    }
+    return 0;
+}
+
+static void freedecompressor(DECOMPRESSOR *decompressor) {
+    /* Release everything but the file descriptor */
+    switch(decompressor->method) {
+#if defined(HAVE_ZSTD)
+    case COMPRESSZSTD:
+        ZSTD_freeDCtx(decompressor->zstd);
+        break;
+#endif
+#if defined(HAVE_ZLIB)
+    case COMPRESSGZIP:
+        inflateEnd(&decompressor->gzip);
+        break;
+#endif
+    }
+    free(decompressor->input);
+}
+
+static char *readintomap(const int fd, const int method, size_t *size, const size_t limit) {
+    /* Read an entire file, decompressing it with method, into an anonymous
+     * memory map and return it. This is for memo files that can't be
+     * mapped directly. Its length is stored in size, and it's released
+     * with munmap(). If limit isn't 0, the map is that long from the start,
+     * so it never has to be copied, and only the pages that are written
+     * take up memory. Files longer than that are an error. */
+    DECOMPRESSOR  decompressor;
+    size_t        pagesize = sysconf(_SC_PAGESIZE);
+    size_t        mapsize = limit ? limit : 16 * DECOMPRESSCHUNKSIZE;
+    size_t        newmapsize;
+    size_t        length = 0;
+    size_t        used;
+    char         *map;
+    char         *newmap;
+    char          extra;
+
+    initdecompressor(&decompressor, method, fd);
+    map = mmap(NULL, mapsize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if(map == MAP_FAILED) {
+        exitwitherror("Unable to map memory for a memo file", 1);
+    }
+    for(;;) {
+        if(length == mapsize) {
+            if(limit) {
+                /* A file that exactly fills the map is fine */
+                if(decompressread(&decompressor, &extra, 1)) {
+                    exitwitherror("The memo file is too large to decompress within --max-memory", 0);
+                }
+                break;
+            }
+            newmapsize = mapsize * 2;
+            newmap = mmap(NULL, newmapsize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if(newmap == MAP_FAILED) {
+                exitwitherror("Unable to map memory for a memo file", 1);
+            }
+            memcpy(newmap, map, length);
+            munmap(map, mapsize);
+            map = newmap;
+            mapsize = newmapsize;
+        }
+        used = decompressread(&decompressor, map + length, mapsize - length);
+        if(!used) {
+            break;
+        }
+        length += used;
+    }
+    freedecompressor(&decompressor);
+
+    /* Give back the pages past the end of the file, so that unmapping its
+     * length later releases all of it */
+    used = (length + pagesize - 1) / pagesize * pagesize;
+    if(!used) {
+        used = pagesize;
+    }
+    if(used < mapsize) {
+        munmap(map + used, mapsize - used);
+    }
+    *size = length;
+    return map;
+}
+
+/* Scratch memory */
+
+static void freearenachunk(ARENA *arena, ARENACHUNK *chunk) {
+    /* Give a chunk back to the system */
+    arena->size -= chunk->size;
+    free(chunk);
+}
+
+static void addarenachunk(ARENA *arena, const size_t size) {
+    /* Start a new chunk that holds at least size bytes, reusing the spare
+     * chunk if it's big enough */
+    ARENACHUNK *chunk = arena->spare;
+
+    arena->spare = NULL;
+    if(chunk == NULL || chunk->size < size) {
+        if(chunk != NULL) {
+            freearenachunk(arena, chunk);
+        }
+        if(arena->limit && arena->size + size > arena->limit) {
+            exitwitherror("Formatting a value needs more memory than --max-memory allows", 0);
+        }
+        chunk = malloc(sizeof(ARENACHUNK) + size);
+        if(chunk == NULL) {
+            exitwitherror("Unable to malloc scratch memory", 1);
+        }
+        if(arena->chunk != NULL && arena->stats != NULL) {
+            arena->stats->buffergrowths++;
+        }
+        chunk->size = size;
+        arena->size += size;
+        if(arena->size > arena->peak) {
+            arena->peak = arena->size;
+        }
+    }
+    chunk->previous = arena->chunk;
+    chunk->used = 0;
+    arena->chunk = chunk;
+}
+
+static void initarena(ARENA *arena, const size_t limit, STATS *stats) {
+    /* Prepare an arena with its first chunk. If limit isn't 0, the arena
+     * can't grow past that many bytes. */
+    arena->chunk = NULL;
+    arena->spare = NULL;
+    arena->size = 0;
+    arena->peak = 0;
+    arena->limit = limit && limit < ARENAMINIMUM ? ARENAMINIMUM : limit;
+    arena->stats = stats;
+    addarenachunk(arena, ARENACHUNKSIZE);
+}
+
+static void *arenaalloc(ARENA *arena, size_t size) {
+    /* Return size bytes of scratch memory, aligned for any of the types
+     * that PgDBF stores there */
+    ARENACHUNK *chunk;
+    char       *allocated;
+
+    size = (size + sizeof(uint64_t) - 1) & ~(sizeof(uint64_t) - 1);
+    if(arena->chunk->used + size > arena->chunk->size) {
+        addarenachunk(arena, size > ARENACHUNKSIZE ? size : ARENACHUNKSIZE);
+    }
+    chunk = arena->chunk;
+    allocated = (char *) (chunk + 1) + chunk->used;
+    chunk->used += size;
+    return allocated;
+}
+
+static ARENAMARK arenamark(const ARENA *arena) {
+    /* Remember how much of the arena is in use */
+    ARENAMARK mark;
+
+    mark.chunk = arena->chunk;
+    mark.used = arena->chunk->used;
+    return mark;
+}
+
+static void arenarelease(ARENA *arena, const ARENAMARK mark) {
+    /* Give back everything allocated since the mark was taken. Of the
+     * chunks that were added for it, only the largest is kept. */
+    ARENACHUNK *chunk;
+
+    while(arena->chunk != mark.chunk) {
+        chunk = arena->chunk;
+        arena->chunk = chunk->previous;
+        if(arena->spare == NULL || chunk->size > arena->spare->size) {
+            if(arena->spare != NULL) {
+                freearenachunk(arena, arena->spare);
+            }
+            arena->spare = chunk;
+        } else {
+            freearenachunk(arena, chunk);
+        }
+    }
+    arena->chunk->used = mark.used;
+}
+
+static void resetarena(ARENA *arena) {
+    /* Give back everything, keeping only the first chunk */
+    ARENACHUNK *chunk;
+
+    while(arena->chunk->previous != NULL) {
+        chunk = arena->chunk;
+        arena->chunk = chunk->previous;
+        freearenachunk(arena, chunk);
+    }
+    if(arena->spare != NULL) {
+        freearenachunk(arena, arena->spare);
+        arena->spare = NULL;
+    }
+    arena->chunk->used = 0;
+}
+
+static void freearena(ARENA *arena) {
+    /* Free all of the arena's memory, adding its peak size to the stats */
+    resetarena(arena);
+    free(arena->chunk);
+    arena->chunk = NULL;
+    if(arena->stats != NULL && arena->peak > arena->stats->arenapeak) {
+        arena->stats->arenapeak = arena->peak;
+    }
+}
+
+/* Character set conversion */
+
+static const CODEPAGE *findcodepage(const char *name) {
+    /* Return the lookup table for the named codepage, or NULL if there
+     * isn't one. Case, dashes, and underscores are ignored so that
+     * "cp1252", "CP-1252", and "windows-1252" all match. */
+    char        normalized[32];
+    const char *alias;
+    size_t      length = 0;
+    size_t      namelength;
+    int         i;
+
+    for(; *name; name++) {
+        if(*name == '-' || *name == '_') {
+            continue;
+        }
+        if(length == sizeof(normalized) - 1) {
+            return NULL;
+        }
+        normalized[length++] = toupper((unsigned char) *name);
+    }
+    normalized[length] = '\0';
+
+    for(i = 0; CODEPAGES[i].name != NULL; i++) {
+        if(!strcmp(CODEPAGES[i].name, normalized)) {
+            return &CODEPAGES[i];
+        }
+        for(alias = CODEPAGES[i].aliases; *alias; alias += namelength) {
+            while(*alias == ' ') {
+                alias++;
+            }
+            namelength = strcspn(alias, " ");
+            if(namelength == length && !strncmp(alias, normalized, length)) {
+                return &CODEPAGES[i];
+            }
+        }
+    }
+    return NULL;
+}
+
+static const char *codepageforlanguage(const uint8_t language) {
+    /* Return the name of the codepage that a DBF header's language byte
+     * refers to, or NULL if it's not one we know */
+    int i;
+
+    for(i = 0; LANGUAGECODEPAGES[i].codepage != NULL; i++) {
+        if(LANGUAGECODEPAGES[i].language == language) {
+            return LANGUAGECODEPAGES[i].codepage;
+        }
+    }
+    return NULL;
+}
+
+static const char *transcode(FORMATTER *formatter, const char *buf, size_t *length) {
+    /* Convert buf from the formatter's single-byte codepage to UTF-8,
+     * updating length to the converted length. Runs of ASCII are copied
+     * as is, and a value that's entirely ASCII isn't copied at all. */
+    const uint8_t *entry;
+    const char    *s = buf;
+    const char    *end = buf + *length;
+    char          *converted;
+    char          *u;
+    size_t         ascii;
+
+    ascii = findnonascii(s, *length);
+    if(ascii == *length) {
+        return buf;
+    }
+
+    /* No byte turns into more than three bytes of UTF-8 */
+    converted = arenaalloc(&formatter->arena, *length * 3);
+    u = converted;
+    for(;;) {
+        memcpy(u, s, ascii);
+        u += ascii;
+        s += ascii;
+        if(s == end) {
+            break;
+        }
+        entry = formatter->codepage->toutf8[(uint8_t) *s - 0x80];
+        if(!entry[0]) {
+            fprintf(stderr, "Invalid byte 0x%02X for codepage %s.\n", (uint8_t) *s, formatter->codepage->name);
+            exit(1);
+        }
+        memcpy(u, entry + 1, 3);
+        u += entry[0];
+        s++;
+        ascii = findnonascii(s, end - s);
+    }
+    *length = u - converted;
+    return converted;
+}
+
+#if defined(HAVE_ICONV)
+static const char *convertcharset(FORMATTER *formatter, const char **inputstring, const char *end, size_t *length) {
+    /* Convert up to VALUEPIECESIZE bytes starting at *inputstring with
+     * iconv, moving *inputstring past the bytes that were used. A multibyte
+     * sequence that's cut off by the end of the piece is left for the
+     * next one. */
+    char   *inbuf = (char *) *inputstring;
+    char   *outbuf;
+    char   *outbufstart;
+    size_t  inbytesleft;
+    size_t  outbyteslen;
+    size_t  outbytesleft;
+    size_t  iconv_value;
+
+    inbytesleft = end - *inputstring < VALUEPIECESIZE ? end - *inputstring : VALUEPIECESIZE;
+    outbyteslen = inbytesleft * 4 + 1;
+    outbytesleft = outbyteslen;
+    outbufstart = outbuf = arenaalloc(&formatter->arena, outbyteslen);
+
+    iconv_value = iconv(formatter->conv_desc, &inbuf, &inbytesleft, &outbuf, &outbytesleft);
+
+    /* Handle failures. Running out of input or output partway through a
+     * piece just means there's more to convert. */
+    if(iconv_value == (size_t)-1 &&
+       !(errno == EINVAL && *inputstring + VALUEPIECESIZE < end) &&
+       !(errno == E2BIG && outbuf > outbufstart)) {
+        fprintf(stderr, "iconv failed\n");
+        switch(errno) {
+            case EILSEQ:
+                fprintf(stderr, "Invalid multibyte sequence.\n");
+                break;
+            case EINVAL:
+                fprintf(stderr, "Incomplete multibyte sequence.\n");
+                break;
+            case E2BIG:
+                fprintf(stderr, "No more room (increase size of outbuf in pgdbf.h).\n");
+                break;
+            default:
+                fprintf(stderr, "Error: %s.\n", strerror(errno));
+        }
+        exit(1);
+    }
+
+    *inputstring = inbuf;
+    *length = outbyteslen - outbytesleft;
+    return outbufstart;
+}
+#endif
+
+static const char *convertpiece(FORMATTER *formatter, const char **s, const char *end, size_t *length) {
+    /* Return the next piece of a value, converted to UTF-8 if needed, and
+     * move *s past it. The converted bytes are in the formatter's arena
+     * and can be released as soon as they've been written. */
+    const char *piece = *s;
+    uint64_t    started;
+
+    if(formatter->codepage != NULL) {
+        started = statsclock(formatter->stats);
+        *length = end - *s < VALUEPIECESIZE ? end - *s : VALUEPIECESIZE;
+        *s += *length;
+        piece = transcode(formatter, piece, length);
+        statsphase(formatter->stats, STATCONVERT, started);
+        return piece;
+    }
+#if defined(HAVE_ICONV)
+    if(formatter->conv_desc != NULL) {
+        started = statsclock(formatter->stats);
+        piece = convertcharset(formatter, s, end, length);
+        statsphase(formatter->stats, STATCONVERT, started);
+        return piece;
+    }
+#endif
+    *length = end - *s < VALUEPIECESIZE ? end - *s : VALUEPIECESIZE;
+    *s += *length;
+    return piece;
+}
+
+static size_t measurevalue(FORMATTER *formatter, const char *buf, const char *end) {
+    /* Return how long a value will be once it's converted and cut off at
+     * its first NUL, the way safeprintbuf() writes it */
+    const char *piece;
+    const char *nul;
+    size_t      total = 0;
+    size_t      length;
+    ARENAMARK   mark;
+
+    while(buf < end) {
+        mark = arenamark(&formatter->arena);
+        piece = convertpiece(formatter, &buf, end, &length);
+        nul = memchr(piece, '\0', length);
+        total += nul != NULL ? (size_t) (nul - piece) : length;
+        arenarelease(&formatter->arena, mark);
+        if(nul != NULL) {
+            break;
+        }
+    }
+#if defined(HAVE_ICONV)
+    /* Start the real conversion from the same state */
+    if(formatter->conv_desc != NULL) {
+        iconv(formatter->conv_desc, NULL, NULL, NULL, NULL);
+    }
+#endif
+    return total;
+}
+
+static void safeprintbuf(FORMATTER *formatter, const char *buf, const size_t inputsize, const int trimpadding) {
+    /* Print a string, insuring that it's fit for use in a tab-delimited
+     * text file. In binary mode, print it as a length-prefixed value
+     * instead. Long values are converted and written a piece at a time so
+     * that they don't have to be held in memory all at once. */
+    const char *piece;
+    const char *nul;
+    const char *s;
+    const char *end;
+    size_t     realsize = 0;
+    size_t     length;
+    ARENAMARK  mark;
+
+    /* Shortcut for empty strings */
+    if(*buf == '\0') {
+        realsize = 0;
+    }
+    /* Remove padding added to fixed size fields */
+    else if(trimpadding) {
+        realsize = trimmedlength(buf, inputsize);
+    }
+    else {
+        realsize = inputsize;
+    }
+
+    /* If there aren't any non-space characters, skip the output part */
+    if(!realsize) {
+        if(formatter->binary) {
+            outbufnetint32(formatter->output, 0);
+        }
+        return;
+    }
+
+    /* A binary value starts with its length. A long one is converted once
+     * just to measure it, and again to write it. */
+    end = buf + realsize;
+    if(formatter->binary && realsize > VALUEPIECESIZE) {
+        outbufnetint32(formatter->output, measurevalue(formatter, buf, end));
+    }
+
+    s = buf;
+    while(s < end) {
+        mark = arenamark(&formatter->arena);
+        piece = convertpiece(formatter, &s, end, &length);
+
+        /* Older versions stopped printing at the first NUL, so keep doing
+         * that. */
+        nul = memchr(piece, '\0', length);
+        if(nul != NULL) {
+            length = nul - piece;
+        }
+
+        if(!formatter->binary) {
+            outbufescaped(formatter->output, piece, length);
+        } else if(realsize > VALUEPIECESIZE) {
+            outbufwrite(formatter->output, piece, length);
+        } else {
+            /* A short value is always converted in one piece */
+            if(nul == NULL && s < end) {
+                exitwitherror("A value didn't fit in the conversion buffer", 0);
+            }
+            outbufnetint32(formatter->output, length);
+            outbufwrite(formatter->output, piece, length);
+        }
+        arenarelease(&formatter->arena, mark);
+        if(nul != NULL) {
+            break;
+        }
+    }
+}
+
+int progressdots = 1;
+
+void updateprogressbar(int percent) {
+    int newprogressdots = percent / 2;
+    for(; progressdots <= newprogressdots; progressdots++) {
+        putc('.', stderr);
+        if(progressdots && !(progressdots % 5)){
+            fprintf(stderr, "%d", progressdots * 2);
+        }
+    }
+    if(percent == 100) {
+        fprintf(stderr, "\n");
+    }
+    fflush(stderr);
+}
+
+/* Endian-specific code.  Define functions to convert input data to the
+ * required form depending on the endianness of the host architecture. */
+
+#define SWAP8BYTES(rightend, wrongendcharptr)   \
+    const char *src = wrongendcharptr + 7;      \
+    memcpy((char *) &rightend    , src--, 1);   \
+    memcpy((char *) &rightend + 1, src--, 1);   \
+    memcpy((char *) &rightend + 2, src--, 1);   \
+    memcpy((char *) &rightend + 3, src--, 1);   \
+    memcpy((char *) &rightend + 4, src--, 1);   \
+    memcpy((char *) &rightend + 5, src--, 1);   \
+    memcpy((char *) &rightend + 6, src--, 1);   \
+    memcpy((char *) &rightend + 7, src  , 1);
+
+#define SWAPANDRETURN8BYTES(wrongendcharptr)   \
+    int64_t rightend;                          \
+    SWAP8BYTES(rightend, wrongendcharptr)      \
+    return rightend;
+
+#define SWAPANDRETURN4BYTES(wrongendcharptr)   \
+    const char *src = wrongendcharptr + 3;     \
+    int32_t rightend;                          \
+    memcpy((char*) &rightend    , src--, 1);   \
+    memcpy((char*) &rightend + 1, src--, 1);   \
+    memcpy((char*) &rightend + 2, src--, 1);   \
+    memcpy((char*) &rightend + 3, src  , 1);   \
+    return rightend;
+
+#define SWAPANDRETURN2BYTES(wrongendcharptr)   \
+    const char *src = wrongendcharptr + 1;     \
+    int16_t rightend;                          \
+    memcpy((char*) &rightend    , src--, 1);   \
+    memcpy((char*) &rightend + 1, src  , 1);   \
+    return rightend;
+
+/* Integer-to-integer */
+
+static int64_t nativeint64_t(const int64_t rightend) {
+    /* Leave a 64-bit integer alone */
+    return rightend;
+}
+
+static int64_t swappedint64_t(const int64_t wrongend) {
+    /* Change the endianness of a 64-bit integer */
+    SWAPANDRETURN8BYTES(((char *) &wrongend))
+}
+
+static int32_t nativeint32_t(const int32_t rightend) {
+    /* Leave a 32-bit integer alone */
+    return rightend;
+}
+
+static int32_t swappedint32_t(const int32_t wrongend) {
+    /* Change the endianness of a 32-bit integer */
+    SWAPANDRETURN4BYTES(((char*) &wrongend))
+}
+
+static int16_t nativeint16_t(const int16_t rightend) {
+    /* Leave a 16-bit integer alone */
+    return rightend;
+}
+
+static int16_t swappedint16_t(const int16_t wrongend) {
+    /* Change the endianness of a 16-bit integer */
+    SWAPANDRETURN2BYTES(((char*) &wrongend))
+}
+
+/* String-to-integer */
+
+static int64_t snativeint64_t(const char *buf) {
+    /* Interpret the first 8 bytes of buf as a 64-bit int */
+    int64_t output;
+    memcpy(&output, buf, 8);
+    return output;
+}
+
+static int64_t sswappedint64_t(const char *buf) {
+    /* The byte-swapped version of snativeint64_t */
+    SWAPANDRETURN8BYTES(buf)
+}
+
+static int32_t snativeint32_t(const char *buf) {
+    /* Interpret the first 4 bytes of buf as a 32-bit int */
+    int32_t output;
+    memcpy(&output, buf, 4);
+    return output;
+}
+
+static int32_t sswappedint32_t(const char *buf) {
+    /* The byte-swapped version of snativeint32_t */
+    SWAPANDRETURN4BYTES(buf)
+}
+
+static int16_t snativeint16_t(const char *buf) {
+    /* Interpret the first 2 bytes of buf as a 16-bit int */
+    int16_t output;
+    memcpy(&output, buf, 2);
+    return output;
+}
+
+static int16_t sswappedint16_t(const char *buf) {
+    /* The byte-swapped version of snativeint16_t */
+    SWAPANDRETURN2BYTES(buf)
+}
+
+#ifdef WORDS_BIGENDIAN
+#define bigint64_t     nativeint64_t
+#define littleint64_t  swappedint64_t
+
+#define bigint32_t     nativeint32_t
+#define littleint32_t  swappedint32_t
+
+#define bigint16_t     nativeint16_t
+#define littleint16_t  swappedint16_t
+
+#define sbigint64_t    snativeint64_t
+#define slittleint64_t sswappedint64_t
+
+#define sbigint32_t    snativeint32_t
+#define slittleint32_t sswappedint32_t
+
+#define sbigint16_t    snativeint16_t
+#define slittleint16_t sswappedint16_t
+
+static double sdouble(const char *buf) {
+    /* Doubles are stored as 64-bit little-endian, so swap ends */
+    union {
+        int64_t asint64;
+        double  asdouble;
+    } inttodouble;
+
+    SWAP8BYTES(inttodouble.asint64, buf)
+    return inttodouble.asdouble;
+}
+#else
+#define bigint64_t     swappedint64_t
+#define littleint64_t  nativeint64_t
+
+#define bigint32_t     swappedint32_t
+#define littleint32_t  nativeint32_t
+
+#define bigint16_t     swappedint16_t
+#define littleint16_t  nativeint16_t
+
+#define sbigint64_t    sswappedint64_t
+#define slittleint64_t snativeint64_t
+
+#define sbigint32_t    sswappedint32_t
+#define slittleint32_t snativeint32_t
+
+#define sbigint16_t    sswappedint16_t
+#define slittleint16_t snativeint16_t
+
+static double sdouble(const char *buf) {
+    /* Interpret the first 8 bytes of buf as a double */
+    double output;
+    memcpy(&output, buf, 8);
+    return output;
+}
+
+#endif
+
+/* Record formatting.  These turn batches of raw DBF records into lines of
+ * PostgreSQL COPY input. */
+
+static void initformatter(FORMATTER *formatter, OUTBUF *sharedoutput, const size_t longestfield, const int binary, const char *inputcharset,
+                          const size_t memorylimit, STATS *stats) {
+    /* Prepare a formatter for use. If sharedoutput is NULL, records will be
+     * collected in memory until the caller writes them out. If memorylimit
+     * isn't 0, the formatter's scratch memory can't grow past it. If stats
+     * isn't NULL, the formatter adds its counters and timers to it. */
+    formatter->binary = binary;
+    formatter->stats = stats;
+    formatter->cachedjulianday = -1;
+    if(sharedoutput != NULL) {
+        formatter->output = sharedoutput;
+    } else {
+        initoutbuf(&formatter->privateoutput, -1, OUTBUFFLUSHSIZE);
+        formatter->privateoutput.stats = stats;
+        formatter->output = &formatter->privateoutput;
+    }
+    formatter->outputbuffer = malloc(longestfield + 1);
+    if(formatter->outputbuffer == NULL) {
+        exitwitherror("Unable to malloc the output buffer", 1);
+    }
+
+    initarena(&formatter->arena, memorylimit, stats);
+    formatter->codepage = NULL;
+    if(inputcharset != NULL) {
+        formatter->codepage = findcodepage(inputcharset);
+    }
+
+#if defined(HAVE_ICONV)
+    formatter->conv_desc = NULL;
+    if(inputcharset != NULL && formatter->codepage == NULL) {
+        const char *outputcharset = "UTF-8";
+        formatter->conv_desc = iconv_open(outputcharset, inputcharset);
+
+        if(formatter->conv_desc == (iconv_t)-1) {
+            if(errno == EINVAL) {
+                fprintf(stderr, "Conversion from '%s' to '%s' is not supported.\n", inputcharset, outputcharset);
+            } else {
+                fprintf(stderr, "Initialization failure: %s\n", strerror(errno));
+            }
+
+            exit(1);
+        }
+    }
+#else
+    if(inputcharset != NULL && formatter->codepage == NULL) {
+        fprintf(stderr, "Conversion from '%s' to 'UTF-8' is not supported.\n", inputcharset);
+        exit(1);
+    }
+#endif
+}
+
+static void freeformatter(FORMATTER *formatter) {
+    /* Release everything that initformatter() acquired */
+    if(formatter->output == &formatter->privateoutput) {
+        freeoutbuf(&formatter->privateoutput);
+    }
+    free(formatter->outputbuffer);
+    freearena(&formatter->arena);
+
+#if defined(HAVE_ICONV)
+    if(formatter->conv_desc != NULL) {
+        if(iconv_close(formatter->conv_desc) != 0) {
+            fprintf(stderr, "iconv_close failed: %s\n", strerror(errno));
+            exit(1);
+        }
+    }
+#endif
+}
+
+/* Row filters */
+
+static void compilefilter(FILTER *filter, const char *condition, const DBFFIELD *fields, char (*fieldnames)[MAXCOLUMNNAMESIZE], const size_t fieldcount) {
+    /* Parse a condition like "saledate>=20240101" or "status='A'" into a
+     * filter for this table's records. Field names are matched the same
+     * way as with -i. */
+    static const struct {
+        const char *op;
+        int         comparison;
+    } COMPARISONS[] = {
+        {"==", FILTEREQUAL}, {"!=", FILTERNOTEQUAL}, {"<>", FILTERNOTEQUAL},
+        {"<=", FILTERLESSEQUAL}, {">=", FILTERGREATEREQUAL},
+        {"=", FILTEREQUAL}, {"<", FILTERLESS}, {">", FILTERGREATER},
+        {NULL, 0}
+    };
+    const char *s = condition;
+    const char *namestart;
+    char        name[MAXCOLUMNNAMESIZE];
+    char        value[256];
+    char       *end;
+    size_t      namelength;
+    size_t      valuelength;
+    size_t      fieldnum;
+    size_t      offset = 1;     /* Skip the deletion flag */
+    int         i;
+
+    /* The field name */
+    while(isspace((unsigned char) *s)) {
+        s++;
+    }
+    namestart = s;
+    while(isalnum((unsigned char) *s) || *s == '_') {
+        s++;
+    }
+    namelength = s - namestart;
+    if(!namelength || namelength >= sizeof(name)) {
+        fprintf(stderr, "Invalid --where condition: %s\n", condition);
+        exit(EXIT_FAILURE);
+    }
+    for(i = 0; (size_t) i < namelength; i++) {
+        name[i] = tolower((unsigned char) namestart[i]);
+    }
+    name[namelength] = '\0';
+
+    /* The comparison. Two-character operators are tried first so that
+     * "<=" isn't read as "<". */
+    while(isspace((unsigned char) *s)) {
+        s++;
+    }
+    for(i = 0; COMPARISONS[i].op != NULL; i++) {
+        if(!strncmp(s, COMPARISONS[i].op, strlen(COMPARISONS[i].op))) {
+            break;
+        }
+    }
+    if(COMPARISONS[i].op == NULL) {
+        fprintf(stderr, "Invalid --where condition: %s\n", condition);
+        exit(EXIT_FAILURE);
+    }
+    filter->comparison = COMPARISONS[i].comparison;
+    s += strlen(COMPARISONS[i].op);
+
+    /* The value, which may be quoted */
+    while(isspace((unsigned char) *s)) {
+        s++;
+    }
+    valuelength = strlen(s);
+    while(valuelength && isspace((unsigned char) s[valuelength - 1])) {
+        valuelength--;
+    }
+    if(valuelength >= 2 && s[0] == '\'' && s[valuelength - 1] == '\'') {
+        s++;
+        valuelength -= 2;
+    }
+    if(valuelength >= sizeof(value)) {
+        fprintf(stderr, "The value in --where condition %s is too long\n", condition);
+        exit(EXIT_FAILURE);
+    }
+    memcpy(value, s, valuelength);
+    value[valuelength] = '\0';
+
+    /* Find the field */
+    for(fieldnum = 0; fieldnum < fieldcount; fieldnum++) {
+        if(!strcmp(fieldnames[fieldnum], name)) {
+            break;
+        }
+        offset += fields[fieldnum].length;
+    }
+    if(fieldnum == fieldcount) {
+        fprintf(stderr, "The table has no field named %s\n", name);
+        exit(EXIT_FAILURE);
+    }
+    filter->offset = offset;
+    filter->length = fields[fieldnum].length;
+    filter->type = fields[fieldnum].type;
+
+    switch(filter->type) {
+    case 'C':
+        /* Character fields are padded with spaces */
+        if(valuelength > filter->length) {
+            fprintf(stderr, "The value in --where condition %s is longer than the field\n", condition);
+            exit(EXIT_FAILURE);
+        }
+        memset(filter->value, ' ', filter->length);
+        memcpy(filter->value, value, valuelength);
+        break;
+    case 'D':
+        /* Dates are stored as YYYYMMDD, which sorts the same way as the
+         * dates themselves. YYYY-MM-DD is accepted too. */
+        for(i = 0, s = value; *s && i < 8; s++) {
+            if(isdigit((unsigned char) *s)) {
+                filter->value[i++] = *s;
+            } else if(*s != '-') {
+                break;
+            }
+        }
+        if(i != 8 || *s) {
+            fprintf(stderr, "The date in --where condition %s has to look like YYYYMMDD\n", condition);
+            exit(EXIT_FAILURE);
+        }
+        break;
+    case 'F':
+    case 'I':
+    case 'N':
+        filter->number = strtod(value, &end);
+        if(end == value || *end) {
+            fprintf(stderr, "The value in --where condition %s isn't a number\n", condition);
+            exit(EXIT_FAILURE);
+        }
+        break;
+    case 'L':
+        filter->value[0] = toupper((unsigned char) value[0]);
+        if(filter->value[0] == 'Y') {
+            filter->value[0] = 'T';
+        } else if(filter->value[0] == 'N') {
+            filter->value[0] = 'F';
+        }
+        if(valuelength != 1 || (filter->value[0] != 'T' && filter->value[0] != 'F') ||
+           (filter->comparison != FILTEREQUAL && filter->comparison != FILTERNOTEQUAL)) {
+            fprintf(stderr, "Logical fields can only be compared with = or != to T or F: %s\n", condition);
+            exit(EXIT_FAILURE);
+        }
+        break;
+    default:
+        fprintf(stderr, "--where can't test fields of type %c: %s\n", filter->type, condition);
+        exit(EXIT_FAILURE);
+    }
+}
+
+static int recordmatches(const TABLEINFO *table, const char *record) {
+    /* Return 1 if the record passes all of the table's filters. Blank
+     * dates, numbers, and logicals are NULL and never pass. */
+    const FILTER *filter;
+    const char   *value;
+    char          number[256];
+    double        difference;
+    int           order;
+    char          logical;
+
+    for(filter = table->filters; filter < table->filters + table->filtercount; filter++) {
+        value = record + filter->offset;
+        switch(filter->type) {
+        case 'C':
+            order = memcmp(value, filter->value, filter->length);
+            break;
+        case 'D':
+            if(value[0] == ' ' || value[0] == '\0') {
+                return 0;
+            }
+            order = memcmp(value, filter->value, 8);
+            break;
+        case 'F':
+        case 'N':
+            memcpy(number, value, filter->length);
+            number[filter->length] = '\0';
+            if(strspn(number, " ") == filter->length) {
+                return 0;
+            }
+            difference = strtod(number, NULL) - filter->number;
+            order = (difference > 0) - (difference < 0);
+            break;
+        case 'I':
+            difference = (double) slittleint32_t(value) - filter->number;
+            order = (difference > 0) - (difference < 0);
+            break;
+        default:
+            /* 'L' */
+            logical = toupper((unsigned char) value[0]);
+            if(logical == 'Y') {
+                logical = 'T';
+            } else if(logical == 'N') {
+                logical = 'F';
+            } else if(logical != 'T' && logical != 'F') {
+                return 0;
+            }
+            order = logical != filter->value[0];
+            break;
+        }
+        switch(filter->comparison) {
+        case FILTEREQUAL:
+            if(order) return 0;
+            break;
+        case FILTERNOTEQUAL:
+            if(!order) return 0;
+            break;
+        case FILTERLESS:
+            if(order >= 0) return 0;
+            break;
+        case FILTERLESSEQUAL:
+            if(order > 0) return 0;
+            break;
+        case FILTERGREATER:
+            if(order <= 0) return 0;
+            break;
+        case FILTERGREATEREQUAL:
+            if(order < 0) return 0;
+            break;
+        }
+    }
+    return 1;
+}
+
+/* Formatting records */
+
+static int32_t parsememoblock(const PGFIELD *pgfield, const char *bufoffset) {
+    /* Return the memo block number stored in a memo field */
+    const char *s;
+    int32_t     memoblocknumber;
+    int         i;
+
+    if(pgfield->memonumbering == PACKEDMEMOSTYLE) {
+        return slittleint32_t(bufoffset);
+    }
+    memoblocknumber = 0;
+    s = bufoffset;
+    for(i = 0; i < 10; i++) {
+        if(*s && *s != 32) {
+            /* I'm unaware of any non-ASCII
+             * implementation of XBase. */
+            memoblocknumber = memoblocknumber * 10 + *s - '0';
+        }
+        s++;
+    }
+    return memoblocknumber;
+}
+
+static int ismemotype(const char type) {
+    /* Whether a field of this type holds a memo block number */
+    return type == 'M' || type == 'G' || type == 'P';
+}
+
+static const char *memovalue(const TABLEINFO *table, const PGFIELD *pgfield, const char *bufoffset, size_t *length) {
+    /* Find the memo referenced by a memo field. Returns NULL if the field
+     * doesn't point to a memo. */
+    const char *memorecord;
+    const char *t;
+    size_t      memorecordoffset;
+    int32_t     memoblocknumber = parsememoblock(pgfield, bufoffset);
+
+    if(!memoblocknumber) {
+        return NULL;
+    }
+    memorecordoffset = table->memoblocksize * memoblocknumber;
+    if(memorecordoffset >= table->memofilesize) {
+        exitwitherror("A memo record past the end of the memofile was requested", 0);
+    }
+    memorecord = table->memomap + memorecordoffset;
+    if(table->memofileisdbase3) {
+        t = strchr(memorecord, 0x1A);
+        *length = t - memorecord;
+        return memorecord;
+    }
+    if(memorecordoffset + 8 > table->memofilesize) {
+        exitwitherror("A memo record past the end of the memofile was requested", 0);
+    }
+    *length = sbigint32_t(memorecord + 4);
+    if(*length > table->memofilesize - memorecordoffset - 8) {
+        /* Don't read past the end of a truncated memofile */
+        *length = table->memofilesize - memorecordoffset - 8;
+    }
+    return memorecord + 8;
+}
+
+static void releasememo(const TABLEINFO *table, const char *memorecord, const size_t length) {
+    /* Drop the pages of a memo that was long enough to be written a piece
+     * at a time. Otherwise a few huge memos could fill memory before the
+     * batch is done. Only the pages entirely inside the memo are dropped,
+     * since other memos may share the ones at its ends. */
+#if defined(HAVE_MADVISE)
+    size_t pagesize;
+    size_t start;
+    size_t end;
+
+    if(length <= VALUEPIECESIZE || !table->memomapisfile) {
+        return;
+    }
+    pagesize = sysconf(_SC_PAGESIZE);
+    start = memorecord - table->memomap;
+    start += (pagesize - start % pagesize) % pagesize;
+    end = memorecord - table->memomap + length;
+    end -= end % pagesize;
+    if(end > start) {
+        madvise(table->memomap + start, end - start, MADV_DONTNEED);
+    }
+#endif
+}
+
+static int comparesizes(const void *a, const void *b) {
+    /* qsort() comparison function for size_t's */
+    size_t x = *(const size_t *) a;
+    size_t y = *(const size_t *) b;
+    return x < y ? -1 : x > y;
+}
+
+static void advisememorange(MEMOPREFETCH *prefetch, const TABLEINFO *table, size_t start, size_t end) {
+    /* Ask the kernel to start reading part of the memo file */
+    if(end > table->memofilesize) {
+        end = table->memofilesize;
+    }
+    start -= start % prefetch->pagesize;
+#if defined(HAVE_MADVISE)
+    madvise(table->memomap + start, end - start, MADV_WILLNEED);
+#endif
+    prefetch->rangecount++;
+    prefetch->resident += end - start;
+}
+
+static void prefetchmemos(MEMOPREFETCH *prefetch, ARENA *arena, const TABLEINFO *table, const char *records, const size_t recordcount) {
+    /* Collect the memos referenced by a batch of records, sort them by
+     * their position in the memo file, and ask the kernel to read them in
+     * as few ranges as possible before the batch is formatted. Memos that
+     * are within MEMOPREFETCHGAP bytes of each other are read as a single
+     * range, since reading the gap costs less than seeking over it. Only
+     * the first block of each memo is requested explicitly; longer memos
+     * are left to the kernel's own readahead. The list of memos is kept
+     * in arena until the batch is done.
+     *
+     * With a window, the memo pages read for earlier batches are dropped
+     * once about that many bytes have been requested. They've all been
+     * formatted by now, and any that are needed again are read back in. */
+    const FIELDSTEP *step;
+    const char *record;
+    size_t     *offsets;
+    size_t      memosteps = 0;
+    size_t      recordnum;
+    size_t      count = 0;
+    size_t      offset;
+    size_t      start;
+    size_t      end;
+    size_t      i;
+    int32_t     memoblocknumber;
+
+    if(!prefetch->pagesize) {
+        prefetch->pagesize = sysconf(_SC_PAGESIZE);
+    }
+#if defined(HAVE_MADVISE)
+    if(prefetch->window && prefetch->resident > prefetch->window && table->memomapisfile) {
+        madvise(table->memomap, table->memofilesize, MADV_DONTNEED);
+        prefetch->resident = 0;
+    }
+#endif
+    for(step = table->plan; step < table->plan + table->plansize; step++) {
+        memosteps += ismemotype(step->type);
+    }
+    offsets = arenaalloc(arena, recordcount * memosteps * sizeof(size_t));
+    for(recordnum = 0; recordnum < recordcount; recordnum++) {
+        record = records + table->recordlength * recordnum;
+        if(record[0] == '*' || (table->filtercount && !recordmatches(table, record))) {
+            continue;
+        }
+        for(step = table->plan; step < table->plan + table->plansize; step++) {
+            if(!ismemotype(step->type)) {
+                continue;
+            }
+            memoblocknumber = parsememoblock(step->pgfield, record + step->offset);
+            offset = table->memoblocksize * memoblocknumber;
+            if(memoblocknumber > 0 && offset < table->memofilesize) {
+                offsets[count++] = offset;
+            }
+        }
+    }
+    if(!count) {
+        return;
+    }
+
+    qsort(offsets, count, sizeof(size_t), comparesizes);
+    start = offsets[0];
+    end = start + table->memoblocksize;
+    for(i = 1; i < count; i++) {
+        offset = offsets[i];
+        if(offset > end + MEMOPREFETCHGAP) {
+            advisememorange(prefetch, table, start, end);
+            start = offset;
+        }
+        if(offset + table->memoblocksize > end) {
+            end = offset + table->memoblocksize;
+        }
+    }
+    advisememorange(prefetch, table, start, end);
+    prefetch->memocount += count;
+}
+
+/* Binary COPY output. See the "Binary Format" section of the PostgreSQL
+ * COPY documentation for the details of the file layout. Integers are in
+ * network byte order, and every value is preceded by its length, or by -1
+ * for NULL. */
+
+/* Days between the start of the Julian period and 2000-01-01, which is
+ * PostgreSQL's internal epoch for dates and timestamps */
+#define POSTGRESEPOCHJDATE 2451545
+
+/* The Julian day numbers of 0001-01-01 and 9999-12-31, the range of dates
+ * that can be written as YYYY-MM-DD */
+#define MINISOJDATE 1721426
+#define MAXISOJDATE 5373484
+
+static const char PGCOPYSIGNATURE[] = "PGCOPY\n\377\r\n";
+
+static void writebinaryheader(OUTBUF *output) {
+    /* Start a binary COPY stream: the signature (including its trailing
+     * NUL), a zero flags field, and an empty header extension */
+    outbufwrite(output, PGCOPYSIGNATURE, sizeof(PGCOPYSIGNATURE));
+    outbufnetint32(output, 0);
+    outbufnetint32(output, 0);
+}
+
+static void writebinarytrailer(OUTBUF *output) {
+    /* End a binary COPY stream */
+    outbufnetint16(output, -1);
+}
+
+static int32_t date2j(int year, int month, int day) {
+    /* Convert a calendar date to a Julian day number, exactly as
+     * PostgreSQL's own date2j() does */
+    int32_t julian;
+    int32_t century;
+
+    if(month > 2) {
+        month += 1;
+        year += 4800;
+    } else {
+        month += 13;
+        year += 4799;
+    }
+
+    century = year / 100;
+    julian = year * 365 - 32167;
+    julian += year / 4 - century + century / 4;
+    julian += 7834 * month / 256 + day;
+
+    return julian;
+}
+
+static void j2date(const int32_t jd, int *year, int *month, int *day) {
+    /* Convert a Julian day number to a calendar date, exactly as
+     * PostgreSQL's own j2date() does */
+    uint32_t julian;
+    uint32_t quad;
+    uint32_t extra;
+    int      y;
+
+    julian = jd;
+    julian += 32044;
+    quad = julian / 146097;
+    extra = (julian - quad * 146097) * 4 + 3;
+    julian += 60 + quad * 3 + extra / 146097;
+    quad = julian / 1461;
+    julian -= quad * 1461;
+    y = julian * 4 / 1461;
+    julian = ((y != 0) ? ((julian + 305) % 365) : ((julian + 306) % 366)) + 123;
+    y += quad * 4;
+    *year = y - 4800;
+    quad = julian * 2141 / 65536;
+    *day = julian - 7834 * quad / 256;
+    *month = (quad + 10) % 12 + 1;
+}
+
+static int parsedigits(const char *buf, const int count) {
+    /* Interpret count ASCII digits as a number, or return -1 if any of them
+     * aren't digits */
+    int value = 0;
+    int i;
+
+    for(i = 0; i < count; i++) {
+        if(buf[i] < '0' || buf[i] > '9') {
+            return -1;
+        }
+        value = value * 10 + buf[i] - '0';
+    }
+    return value;
+}
+
+static void outbufnumeric(OUTBUF *outbuf, const char *buf, const size_t length) {
+    /* Append a decimal number like "-123.45" as a binary NUMERIC value.
+     * NUMERICs are sent as base-10000 digits, the power of 10000 of the
+     * first digit, a sign, and the number of decimal places to display. */
+    const char *s = buf;
+    const char *end = buf + length;
+    const char *intstart;
+    const char *intend;
+    const char *fracstart;
+    const char *fracend;
+    int16_t     groups[(255 + 3) / 4 + 2];
+    int         groupcount = 0;
+    int         firstgroup = 0;
+    int         weight;
+    int         negative = 0;
+    int         padding;
+    int         digit;
+    int         i;
+
+    while(s < end && *s == ' ') {
+        s++;
+    }
+    while(end > s && end[-1] == ' ') {
+        end--;
+    }
+    if(s < end && (*s == '-' || *s == '+')) {
+        negative = *s++ == '-';
+    }
+    intstart = s;
+    while(s < end && *s >= '0' && *s <= '9') {
+        s++;
+    }
+    intend = s;
+    fracstart = fracend = s;
+    if(s < end && *s == '.') {
+        fracstart = ++s;
+        while(s < end && *s >= '0' && *s <= '9') {
+            s++;
+        }
+        fracend = s;
+    }
+    if(s != end || (intstart == intend && fracstart == fracend) || length > 255) {
+        fprintf(stderr, "Invalid numeric value: %.*s\n", (int) length, buf);
+        exit(EXIT_FAILURE);
+    }
+    while(intstart < intend && *intstart == '0') {
+        intstart++;
+    }
+
+    /* Line the digits up on the decimal point in groups of four */
+    padding = (4 - (intend - intstart) % 4) % 4;
+    weight = (padding + (intend - intstart)) / 4 - 1;
+    digit = 0;
+    for(i = 0; i < padding; i++) {
+        digit++;
+    }
+    groups[0] = 0;
+    for(s = intstart; s < fracend; s++) {
+        if(s == intend) {
+            s = fracstart;
+            if(s == fracend) {
+                break;
+            }
+        }
+        if(digit % 4 == 0) {
+            groups[groupcount] = 0;
+        }
+        groups[groupcount] = groups[groupcount] * 10 + *s - '0';
+        if(++digit % 4 == 0) {
+            groupcount++;
+        }
+    }
+    if(digit % 4) {
+        /* Fill out the last partial group with zeroes */
+        while(digit % 4) {
+            groups[groupcount] *= 10;
+            digit++;
+        }
+        groupcount++;
+    }
+
+    /* Trim zeroes from both ends */
+    while(groupcount > firstgroup && groups[groupcount - 1] == 0) {
+        groupcount--;
+    }
+    while(firstgroup < groupcount && groups[firstgroup] == 0) {
+        firstgroup++;
+        weight--;
+    }
+    if(firstgroup == groupcount) {
+        weight = 0;
+        negative = 0;
+    }
+
+    outbufnetint32(outbuf, 8 + 2 * (groupcount - firstgroup));
+    outbufnetint16(outbuf, groupcount - firstgroup);
+    outbufnetint16(outbuf, weight);
+    outbufnetint16(outbuf, negative ? 0x4000 : 0x0000);
+    outbufnetint16(outbuf, fracend - fracstart);
+    for(i = firstgroup; i < groupcount; i++) {
+        outbufnetint16(outbuf, groups[i]);
+    }
+}
+
+/* Field formatting. Each kind of field has one function for the text COPY
+ * format and one for the binary format. compileplan() picks the right one
+ * for every column once per table, so that formatting a record is just a
+ * walk down the plan. */
+
+static const char *numericdigits(const char *value, const size_t length, const char **end) {
+    /* Find the digits in a numeric field, skipping leading spaces and
+     * anything after a NUL. Returns NULL if the field is blank. */
+    const char *s = value;
+
+    *end = memchr(value, '\0', length);
+    if(*end == NULL) {
+        *end = value + length;
+    }
+    while(s < *end && *s == ' ') {
+        s++;
+    }
+    return s == *end ? NULL : s;
+}
+
+static int parsewholenumber(const char *s, const char *end, int64_t *value) {
+    /* Parse digits found by numericdigits(), with an optional sign and
+     * trailing spaces, into value. Returns 0 if there's anything else or
+     * the number doesn't fit in 64 bits. */
+    uint64_t limit = INT64_MAX;
+    uint64_t number = 0;
+    int      negative = 0;
+    int      digits = 0;
+
+    if(s < end && (*s == '-' || *s == '+')) {
+        negative = *s++ == '-';
+        limit += negative;
+    }
+    for(; s < end && *s >= '0' && *s <= '9'; s++, digits++) {
+        if(number > (limit - (*s - '0')) / 10) {
+            return 0;
+        }
+        number = number * 10 + *s - '0';
+    }
+    while(s < end && *s == ' ') {
+        s++;
+    }
+    if(s != end || !digits) {
+        return 0;
+    }
+    *value = negative ? (int64_t) (0 - number) : (int64_t) number;
+    return 1;
+}
+
+static void textdouble(FORMATTER *formatter, const TABLEINFO *table, const FIELDSTEP *step, const char *value) {
+    /* Double floats */
+    outbuffixed(formatter->output, sdouble(value), step->decimals);
+}
+
+static void formatvarchar(FORMATTER *formatter, const TABLEINFO *table, const FIELDSTEP *step, const char *value) {
+    /* Varchars, which safeprintbuf() writes in either format */
+    safeprintbuf(formatter, value, step->length, table->trimpadding);
+}
+
+static void textdate(FORMATTER *formatter, const TABLEINFO *table, const FIELDSTEP *step, const char *value) {
+    /* Datestamps */
+    char *u;
+
+    if(value[0] == ' ' || value[0] == '\0') {
+        outbufwrite(formatter->output, "\\N", 2);
+        return;
+    }
+    u = outbufreserve(formatter->output, 10);
+    *u++ = value[0];
+    *u++ = value[1];
+    *u++ = value[2];
+    *u++ = value[3];
+    *u++ = '-';
+    *u++ = value[4];
+    *u++ = value[5];
+    *u++ = '-';
+    *u++ = value[6];
+    *u++ = value[7];
+    outbufcommit(formatter->output, 10);
+}
+
+static void textinteger(FORMATTER *formatter, const TABLEINFO *table, const FIELDSTEP *step, const char *value) {
+    /* Integers */
+    outbufint(formatter->output, slittleint32_t(value));
+}
+
+static void textboolean(FORMATTER *formatter, const TABLEINFO *table, const FIELDSTEP *step, const char *value) {
+    /* Booleans */
+    outbufputc(formatter->output, value[0] == 'Y' || value[0] == 'T' ? 't' : 'f');
+}
+
+static void textmemo(FORMATTER *formatter, const TABLEINFO *table, const FIELDSTEP *step, const char *value) {
+    /* Memos */
+    const char *memorecord;
+    size_t      memolength;
+
+    memorecord = memovalue(table, step->pgfield, value, &memolength);
+    if(memorecord != NULL) {
+        if(formatter->stats != NULL) {
+            formatter->stats->memos++;
+            formatter->stats->memobytes += memolength;
+        }
+        safeprintbuf(formatter, memorecord, memolength, table->trimpadding);
+        releasememo(table, memorecord, memolength);
+    }
+}
+
+static void textbytea(FORMATTER *formatter, const TABLEINFO *table, const FIELDSTEP *step, const char *value) {
+    /* General fields, pictures and binary memos, in BYTEA's hex format.
+     * Its leading backslash is doubled for COPY. Fields that don't point
+     * to a memo are NULL. */
+    const char *memorecord;
+    size_t      memolength;
+
+    memorecord = memovalue(table, step->pgfield, value, &memolength);
+    if(memorecord == NULL) {
+        outbufwrite(formatter->output, "\\N", 2);
+        return;
+    }
+    if(formatter->stats != NULL) {
+        formatter->stats->memos++;
+        formatter->stats->memobytes += memolength;
+    }
+    outbufwrite(formatter->output, "\\\\x", 3);
+    outbufhex(formatter->output, memorecord, memolength);
+    releasememo(table, memorecord, memolength);
+}
+
+static void textnumeric(FORMATTER *formatter, const TABLEINFO *table, const FIELDSTEP *step, const char *value) {
+    /* Numerics */
+    const char *s;
+    const char *end;
+
+    s = numericdigits(value, step->length, &end);
+    if(s == NULL) {
+        outbufwrite(formatter->output, "\\N", 2);
+    } else {
+        outbufwrite(formatter->output, s, end - s);
+    }
+}
+
+static void texttimestamp(FORMATTER *formatter, const TABLEINFO *table, const FIELDSTEP *step, const char *value) {
+    /* Timestamps, in ISO format. Neighboring records often share a date, so
+     * the last date converted is kept for reuse. */
+    int32_t juliandays = slittleint32_t(value);
+    int32_t seconds = (slittleint32_t(value + 4) + 1) / 1000;
+    int     year;
+    int     month;
+    int     day;
+    int     hours;
+    int     minutes;
+    char   *u;
+
+    if(!(juliandays || seconds)) {
+        outbufwrite(formatter->output, "\\N", 2);
+        return;
+    }
+    hours = seconds / 3600;
+    seconds -= hours * 3600;
+    minutes = seconds / 60;
+    seconds -= minutes * 60;
+
+    /* PostgreSQL's Julian day notation handles anything outside of the
+     * four-digit years, and times that make no sense */
+    if(juliandays < MINISOJDATE || juliandays > MAXISOJDATE ||
+       hours < 0 || minutes < 0 || seconds < 0 || hours > 24) {
+        outbufprintf(formatter->output, "J%d %02d:%02d:%02d", juliandays, hours, minutes, seconds);
+        return;
+    }
+
+    if(juliandays != formatter->cachedjulianday) {
+        j2date(juliandays, &year, &month, &day);
+        writedigitpair(formatter->cacheddate, year / 100);
+        writedigitpair(formatter->cacheddate + 2, year % 100);
+        formatter->cacheddate[4] = '-';
+        writedigitpair(formatter->cacheddate + 5, month);
+        formatter->cacheddate[7] = '-';
+        writedigitpair(formatter->cacheddate + 8, day);
+        formatter->cachedjulianday = juliandays;
+    }
+    u = outbufreserve(formatter->output, 19);
+    memcpy(u, formatter->cacheddate, 10);
+    u[10] = ' ';
+    writedigitpair(u + 11, hours);
+    u[13] = ':';
+    writedigitpair(u + 14, minutes);
+    u[16] = ':';
+    writedigitpair(u + 17, seconds);
+    outbufcommit(formatter->output, 19);
+}
+
+static void textcurrency(FORMATTER *formatter, const TABLEINFO *table, const FIELDSTEP *step, const char *value) {
+    /* Currency */
+    outbufcurrency(formatter->output, slittleint64_t(value));
+}
+
+static void textempty(FORMATTER *formatter, const TABLEINFO *table, const FIELDSTEP *step, const char *value) {
+    /* Unknown types, which are left blank */
+}
+
+static void binarydouble(FORMATTER *formatter, const TABLEINFO *table, const FIELDSTEP *step, const char *value) {
+    /* Double floats */
+    union {
+        int64_t asint64;
+        double  asdouble;
+    } doubletoint;
+
+    doubletoint.asdouble = sdouble(value);
+    outbufnetint32(formatter->output, 8);
+    outbufnetint64(formatter->output, doubletoint.asint64);
+}
+
+static void binarydate(FORMATTER *formatter, const TABLEINFO *table, const FIELDSTEP *step, const char *value) {
+    /* Datestamps, as days since PostgreSQL's epoch */
+    int year;
+    int month;
+    int day;
+
+    if(value[0] == ' ' || value[0] == '\0') {
+        outbufnetint32(formatter->output, -1);
+        return;
+    }
+    year = parsedigits(value, 4);
+    month = parsedigits(value + 4, 2);
+    day = parsedigits(value + 6, 2);
+    if(year < 0 || month < 1 || month > 12 || day < 1 ||
+       date2j(year, month, day) >= date2j(year + month / 12, month % 12 + 1, 1)) {
+        fprintf(stderr, "Invalid date: %.8s\n", value);
+        exit(EXIT_FAILURE);
+    }
+    outbufnetint32(formatter->output, 4);
+    outbufnetint32(formatter->output, date2j(year, month, day) - POSTGRESEPOCHJDATE);
+}
+
+static void binaryinteger(FORMATTER *formatter, const TABLEINFO *table, const FIELDSTEP *step, const char *value) {
+    /* Integers */
+    outbufnetint32(formatter->output, 4);
+    outbufnetint32(formatter->output, slittleint32_t(value));
+}
+
+static void binaryboolean(FORMATTER *formatter, const TABLEINFO *table, const FIELDSTEP *step, const char *value) {
+    /* Booleans */
+    outbufnetint32(formatter->output, 1);
+    outbufputc(formatter->output, value[0] == 'Y' || value[0] == 'T');
+}
+
+static void binarymemo(FORMATTER *formatter, const TABLEINFO *table, const FIELDSTEP *step, const char *value) {
+    /* Memos. Fields that don't point to a memo are empty strings. */
+    const char *memorecord;
+    size_t      memolength;
+
+    memorecord = memovalue(table, step->pgfield, value, &memolength);
+    if(memorecord == NULL) {
+        outbufnetint32(formatter->output, 0);
+        return;
+    }
+    if(formatter->stats != NULL) {
+        formatter->stats->memos++;
+        formatter->stats->memobytes += memolength;
+    }
+    safeprintbuf(formatter, memorecord, memolength, table->trimpadding);
+    releasememo(table, memorecord, memolength);
+}
+
+static void binarybytea(FORMATTER *formatter, const TABLEINFO *table, const FIELDSTEP *step, const char *value) {
+    /* General fields, pictures and binary memos, as their raw bytes */
+    const char *memorecord;
+    size_t      memolength;
+
+    memorecord = memovalue(table, step->pgfield, value, &memolength);
+    if(memorecord == NULL) {
+        outbufnetint32(formatter->output, -1);
+        return;
+    }
+    if(formatter->stats != NULL) {
+        formatter->stats->memos++;
+        formatter->stats->memobytes += memolength;
+    }
+    outbufnetint32(formatter->output, memolength);
+    outbufwrite(formatter->output, memorecord, memolength);
+    releasememo(table, memorecord, memolength);
+}
+
+static void binarynumeric(FORMATTER *formatter, const TABLEINFO *table, const FIELDSTEP *step, const char *value) {
+    /* Numerics, in PostgreSQL's NUMERIC format unless the column is TEXT */
+    const char *s;
+    const char *end;
+
+    s = numericdigits(value, step->length, &end);
+    if(s == NULL) {
+        outbufnetint32(formatter->output, -1);
+    } else if(step->type == 'F' || table->numericasnumeric) {
+        outbufnumeric(formatter->output, s, end - s);
+    } else {
+        outbufnetint32(formatter->output, end - s);
+        outbufwrite(formatter->output, s, end - s);
+    }
+}
+
+static void binarywholenumber(FORMATTER *formatter, const TABLEINFO *table, const FIELDSTEP *step, const char *value) {
+    /* Numerics that "--narrow-types" made SMALLINT, INTEGER, or BIGINT */
+    const char *s;
+    const char *end;
+    int64_t     number;
+
+    s = numericdigits(value, step->length, &end);
+    if(s == NULL) {
+        outbufnetint32(formatter->output, -1);
+        return;
+    }
+    if(!parsewholenumber(s, end, &number)) {
+        fprintf(stderr, "Invalid whole number: %.*s\n", (int) (end - s), s);
+        exit(EXIT_FAILURE);
+    }
+    outbufnetint32(formatter->output, step->pgfield->integerwidth);
+    if(step->pgfield->integerwidth == 2) {
+        outbufnetint16(formatter->output, number);
+    } else if(step->pgfield->integerwidth == 4) {
+        outbufnetint32(formatter->output, number);
+    } else {
+        outbufnetint64(formatter->output, number);
+    }
+}
+
+static void binarytimestamp(FORMATTER *formatter, const TABLEINFO *table, const FIELDSTEP *step, const char *value) {
+    /* Timestamps, as microseconds since PostgreSQL's epoch */
+    int32_t juliandays = slittleint32_t(value);
+    int32_t seconds = (slittleint32_t(value + 4) + 1) / 1000;
+
+    if(!(juliandays || seconds)) {
+        outbufnetint32(formatter->output, -1);
+        return;
+    }
+    outbufnetint32(formatter->output, 8);
+    outbufnetint64(formatter->output, ((int64_t) (juliandays - POSTGRESEPOCHJDATE) * 86400 + seconds) * 1000000);
+}
+
+static void binarycurrency(FORMATTER *formatter, const TABLEINFO *table, const FIELDSTEP *step, const char *value) {
+    /* Currency, which is stored as an integer count of ten-thousandths */
+    char    *outputbuffer = formatter->outputbuffer;
+    int64_t  currency = slittleint64_t(value);
+    uint64_t magnitude = currency < 0 ? -(uint64_t) currency : (uint64_t) currency;
+
+    sprintf(outputbuffer, "%s%"PRIu64".%04"PRIu64, currency < 0 ? "-" : "", magnitude / 10000, magnitude % 10000);
+    outbufnumeric(formatter->output, outputbuffer, strlen(outputbuffer));
+}
+
+static void binaryempty(FORMATTER *formatter, const TABLEINFO *table, const FIELDSTEP *step, const char *value) {
+    /* Anything that the text format leaves blank */
+    outbufnetint32(formatter->output, 0);
+}
+
+static FIELDSTEP *compileplan(const DBFFIELD *fields, const PGFIELD *pgfields, const size_t fieldcount, const int binary, size_t *stepcount) {
+    /* Build the list of steps that formats a record: one for each column
+     * that's written, with its offset in the record and the function that
+     * formats it. Null flags and ignored fields get no step at all. */
+    FIELDSTEP *plan;
+    FIELDSTEP *step;
+    size_t     offset = 1;      /* Skip the deletion flag */
+    size_t     fieldnum;
+
+    plan = malloc((fieldcount ? fieldcount : 1) * sizeof(FIELDSTEP));
+    if(plan == NULL) {
+        exitwitherror("Unable to malloc the field plan", 1);
+    }
+    step = plan;
+    for(fieldnum = 0; fieldnum < fieldcount; fieldnum++) {
+        if(fields[fieldnum].type == '0' || fields[fieldnum].type == IGNORETYPE) {
+            offset += fields[fieldnum].length;
+            continue;
+        }
+        step->offset = offset;
+        step->length = fields[fieldnum].length;
+        step->decimals = fields[fieldnum].decimals;
+        step->separator = binary || step == plan ? '\0' : '\t';
+        step->type = fields[fieldnum].type;
+        step->pgfield = &pgfields[fieldnum];
+        switch(fields[fieldnum].type) {
+        case 'B':
+            step->format = binary ? binarydouble : textdouble;
+            break;
+        case 'C':
+        case 'W':
+            step->format = formatvarchar;
+            break;
+        case 'D':
+            step->format = binary ? binarydate : textdate;
+            break;
+        case 'I':
+            step->format = binary ? binaryinteger : textinteger;
+            break;
+        case 'L':
+            step->format = binary ? binaryboolean : textboolean;
+            break;
+        case 'G':
+        case 'M':
+        case 'P':
+            if(pgfields[fieldnum].bytea) {
+                step->format = binary ? binarybytea : textbytea;
+            } else {
+                step->format = binary ? binarymemo : textmemo;
+            }
+            break;
+        case 'F':
+        case 'N':
+            if(binary && pgfields[fieldnum].integerwidth) {
+                step->format = binarywholenumber;
+            } else {
+                step->format = binary ? binarynumeric : textnumeric;
+            }
+            break;
+        case 'T':
+            step->format = binary ? binarytimestamp : texttimestamp;
+            break;
+        case 'Y':
+            step->format = binary ? binarycurrency : textcurrency;
+            break;
+        default:
+            step->format = binary ? binaryempty : textempty;
+            break;
+        }
+        offset += fields[fieldnum].length;
+        step++;
+    }
+    *stepcount = step - plan;
+    return plan;
+}
+
+static void formatrecords(FORMATTER *formatter, const TABLEINFO *table, const char *records, const size_t recordcount) {
+    /* Write each of the given records to the formatter's output, as lines
+     * of text or as binary COPY tuples */
+    const FIELDSTEP *plan = table->plan;
+    const FIELDSTEP *planend = table->plan + table->plansize;
+    const FIELDSTEP *step;
+    OUTBUF          *output = formatter->output;
+    STATS           *stats = formatter->stats;
+    uint64_t         fieldstarted = statsclock(stats);
+    size_t           deletedcount = 0;
+    size_t           filteredcount = 0;
+    const char      *record;
+    size_t           recordnum;
+
+    for(recordnum = 0; recordnum < recordcount; recordnum++) {
+        record = records + table->recordlength * recordnum;
+        /* Skip deleted records */
+        if(record[0] == '*') {
+            deletedcount++;
+            continue;
+        }
+        /* Skip records that don't match "--where" before doing any work on
+         * them */
+        if(table->filtercount && !recordmatches(table, record)) {
+            filteredcount++;
+            continue;
+        }
+
+        if(table->binary) {
+            outbufnetint16(output, table->plansize);
+        }
+        for(step = plan; step < planend; step++) {
+            if(step->separator) {
+                outbufputc(output, step->separator);
+            }
+            step->format(formatter, table, step, record + step->offset);
+            if(stats != NULL) {
+                fieldstarted = countfield(stats, step->type, fieldstarted);
+            }
+        }
+        if(!table->binary) {
+            outbufputc(output, '\n');
+        }
+    }
+    if(stats != NULL) {
+        stats->records += recordcount - deletedcount - filteredcount;
+        stats->deletedrecords += deletedcount;
+        stats->filteredrecords += filteredcount;
+    }
+}
+
+#if defined(HAVE_PTHREAD)
+/* One worker thread's share of a batch of records */
+typedef struct {
+    FORMATTER       *formatter;
+    const TABLEINFO *table;
+    const char      *records;
+    size_t           recordcount;
+} FORMATJOB;
+
+static void *formatjobthread(void *arg) {
+    /* Format a slice of a batch inside a worker thread */
+    FORMATJOB *job = (FORMATJOB *) arg;
+    formatrecords(job->formatter, job->table, job->records, job->recordcount);
+    return NULL;
+}
+#endif
+
+static void formatbatch(OUTBUF *output, FORMATTER *formatters, const int jobcount, const TABLEINFO *table, const char *records, const size_t recordcount) {
+    /* Format a batch of records and append them to the output in their
+     * original order. With more than one job, the batch is split into
+     * contiguous slices that are formatted in parallel, each into its own
+     * formatter's private buffer, and then copied out one slice after
+     * another. */
+#if defined(HAVE_PTHREAD)
+    FORMATJOB  jobs[MAXJOBS];
+    pthread_t  threads[MAXJOBS];
+    size_t     slicesize;
+    size_t     offset;
+    int        i;
+
+    if(jobcount > 1) {
+        slicesize = (recordcount + jobcount - 1) / jobcount;
+        offset = 0;
+        for(i = 0; i < jobcount; i++) {
+            jobs[i].formatter = &formatters[i];
+            jobs[i].table = table;
+            jobs[i].records = records + offset * table->recordlength;
+            jobs[i].recordcount = offset < recordcount ? recordcount - offset : 0;
+            if(jobs[i].recordcount > slicesize) {
+                jobs[i].recordcount = slicesize;
+            }
+            offset += jobs[i].recordcount;
+            if(pthread_create(&threads[i], NULL, formatjobthread, &jobs[i])) {
+                exitwitherror("Unable to start a worker thread", 0);
+            }
+        }
+        for(i = 0; i < jobcount; i++) {
+            if(pthread_join(threads[i], NULL)) {
+                exitwitherror("Unable to join a worker thread", 0);
+            }
+            outbufwrite(output, formatters[i].output->data, formatters[i].output->length);
+            formatters[i].output->length = 0;
+        }
+        return;
+    }
+#endif
+    formatrecords(&formatters[0], table, records, recordcount);
+}
+
+static COLUMNSCAN *plancolumnscans(const DBFFIELD *fields, const size_t fieldcount, const int numericasnumeric, const int trimpadding, const int jobcount, size_t *scancount) {
+    /* List the columns whose types "--narrow-types" might change: numbers
+     * that could be integers, and trimmed text that could be shorter
+     * VARCHARs. Each job gets its own copy of the list after the first. */
+    COLUMNSCAN *scans;
+    size_t      offset = 1;     /* Skip the deletion flag */
+    size_t      fieldnum;
+    size_t      count = 0;
+    int         i;
+
+    scans = calloc((fieldcount ? fieldcount : 1) * jobcount, sizeof(COLUMNSCAN));
+    if(scans == NULL) {
+        exitwitherror("Unable to malloc the column scans", 1);
+    }
+    for(fieldnum = 0; fieldnum < fieldcount; offset += fields[fieldnum++].length) {
+        switch(fields[fieldnum].type) {
+        case 'N':
+            if(!numericasnumeric) {
+                continue;
+            }
+            break;
+        case 'F':
+            break;
+        case 'C':
+        case 'W':
+            if(!trimpadding) {
+                continue;
+            }
+            break;
+        default:
+            continue;
+        }
+        scans[count].fieldnum = fieldnum;
+        scans[count].offset = offset;
+        scans[count].length = fields[fieldnum].length;
+        scans[count].type = fields[fieldnum].type;
+        scans[count].integral = 1;
+        scans[count].minimum = INT64_MAX;
+        scans[count].maximum = INT64_MIN;
+        count++;
+    }
+    for(i = 1; i < jobcount; i++) {
+        memcpy(scans + i * count, scans, count * sizeof(COLUMNSCAN));
+    }
+    *scancount = count;
+    return scans;
+}
+
+static void scanrecords(COLUMNSCAN *scans, const size_t scancount, const TABLEINFO *table, const char *records, const size_t recordcount) {
+    /* Add the values in the records that will be loaded to what's known
+     * about each column */
+    COLUMNSCAN *scan;
+    const char *record;
+    const char *s;
+    const char *end;
+    int64_t     number;
+    size_t      length;
+    size_t      recordnum;
+
+    for(recordnum = 0; recordnum < recordcount; recordnum++) {
+        record = records + table->recordlength * recordnum;
+        if(record[0] == '*' || (table->filtercount && !recordmatches(table, record))) {
+            continue;
+        }
+        for(scan = scans; scan < scans + scancount; scan++) {
+            if(scan->type == 'C' || scan->type == 'W') {
+                length = trimmedlength(record + scan->offset, scan->length);
+                if(length > scan->longest) {
+                    scan->longest = length;
+                }
+                continue;
+            }
+            s = numericdigits(record + scan->offset, scan->length, &end);
+            if(s == NULL) {
+                continue;
+            }
+            scan->hasvalue = 1;
+            if(!scan->integral) {
+                continue;
+            }
+            if(!parsewholenumber(s, end, &number)) {
+                scan->integral = 0;
+                continue;
+            }
+            if(number < scan->minimum) {
+                scan->minimum = number;
+            }
+            if(number > scan->maximum) {
+                scan->maximum = number;
+            }
+        }
+    }
+}
+
+#if defined(HAVE_PTHREAD)
+/* One worker thread's share of a batch of records to scan */
+typedef struct {
+    COLUMNSCAN      *scans;
+    size_t           scancount;
+    const TABLEINFO *table;
+    const char      *records;
+    size_t           recordcount;
+} SCANJOB;
+
+static void *scanjobthread(void *arg) {
+    /* Scan a slice of a batch inside a worker thread */
+    SCANJOB *job = (SCANJOB *) arg;
+    scanrecords(job->scans, job->scancount, job->table, job->records, job->recordcount);
+    return NULL;
+}
+#endif
+
+static void scanbatch(COLUMNSCAN *scans, const size_t scancount, const int jobcount, const TABLEINFO *table, const char *records, const size_t recordcount) {
+    /* Scan a batch of records, split into slices the same way as
+     * formatbatch() with each job adding to its own copy of the scans */
+#if defined(HAVE_PTHREAD)
+    SCANJOB    jobs[MAXJOBS];
+    pthread_t  threads[MAXJOBS];
+    size_t     slicesize;
+    size_t     offset;
+    int        i;
+
+    if(jobcount > 1) {
+        slicesize = (recordcount + jobcount - 1) / jobcount;
+        offset = 0;
+        for(i = 0; i < jobcount; i++) {
+            jobs[i].scans = scans + i * scancount;
+            jobs[i].scancount = scancount;
+            jobs[i].table = table;
+            jobs[i].records = records + offset * table->recordlength;
+            jobs[i].recordcount = offset < recordcount ? recordcount - offset : 0;
+            if(jobs[i].recordcount > slicesize) {
+                jobs[i].recordcount = slicesize;
+            }
+            offset += jobs[i].recordcount;
+            if(pthread_create(&threads[i], NULL, scanjobthread, &jobs[i])) {
+                exitwitherror("Unable to start a worker thread", 0);
+            }
+        }
+        for(i = 0; i < jobcount; i++) {
+            if(pthread_join(threads[i], NULL)) {
+                exitwitherror("Unable to join a worker thread", 0);
+            }
+        }
+        return;
+    }
+#endif
+    scanrecords(scans, scancount, table, records, recordcount);
+}
+
+static void narrowfields(PGFIELD *pgfields, COLUMNSCAN *scans, const size_t scancount, const int jobcount) {
+    /* Combine the jobs' scans and pick the narrowest type that holds every
+     * value of each column. Columns without any values get the narrowest
+     * type of their kind. */
+    COLUMNSCAN *scan;
+    COLUMNSCAN *other;
+    PGFIELD    *pgfield;
+    int         i;
+
+    for(scan = scans; scan < scans + scancount; scan++) {
+        for(i = 1; i < jobcount; i++) {
+            other = scan + i * scancount;
+            scan->hasvalue |= other->hasvalue;
+            scan->integral &= other->integral;
+            if(other->minimum < scan->minimum) {
+                scan->minimum = other->minimum;
+            }
+            if(other->maximum > scan->maximum) {
+                scan->maximum = other->maximum;
+            }
+            if(other->longest > scan->longest) {
+                scan->longest = other->longest;
+            }
+        }
+        pgfield = &pgfields[scan->fieldnum];
+        if(scan->type == 'C' || scan->type == 'W') {
+            pgfield->varcharlength = scan->longest ? scan->longest : 1;
+        } else if(!scan->integral) {
+            /* Stays NUMERIC */
+        } else if(!scan->hasvalue || (scan->minimum >= INT16_MIN && scan->maximum <= INT16_MAX)) {
+            pgfield->integerwidth = 2;
+        } else if(scan->minimum >= INT32_MIN && scan->maximum <= INT32_MAX) {
+            pgfield->integerwidth = 4;
+        } else {
+            pgfield->integerwidth = 8;
+        }
+    }
+}
+
+static const char *integertypename(const int width) {
+    /* The PostgreSQL type for a whole number column of this many bytes */
+    return width == 2 ? "SMALLINT" : width == 4 ? "INTEGER" : "BIGINT";
+}
+
+static void initdbfreader(DBFREADER *reader, FILE *file, const int usemmap) {
+    /* Prepare to read the open .dbf file, mapping it into memory if
+     * possible. This has to be called before anything is read from the
+     * file so that the fallback path can still change its buffering. */
+    struct stat dbfstat;
+
+    memset(reader, 0, sizeof(DBFREADER));
+    reader->file = file;
+    if(usemmap &&
+       fstat(fileno(file), &dbfstat) == 0 &&
+       S_ISREG(dbfstat.st_mode) &&
+       dbfstat.st_size > 0 &&
+       (off_t) (size_t) dbfstat.st_size == dbfstat.st_size) {
+        reader->map = mmap(NULL, dbfstat.st_size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+        if(reader->map == MAP_FAILED) {
+            reader->map = NULL;
+        } else {
+            reader->mapsize = dbfstat.st_size;
+        }
+    }
+    if(reader->map == NULL) {
+        if(setvbuf(file, NULL, _IOFBF, DBFBATCHTARGET)) {
+            exitwitherror("Unable to set the buffer for the dbf file", 1);
+        }
+    }
+}
+
+#if defined(HAVE_PTHREAD)
+static void *decompressdbfthread(void *arg) {
+    /* Decompress the DBF file into the reader's pipe until it ends or the
+     * reader stops needing it */
+    DBFREADER *reader = (DBFREADER *) arg;
+    char      *buf;
+    size_t     length;
+    int        stopping;
+
+    buf = malloc(DECOMPRESSCHUNKSIZE);
+    if(buf == NULL) {
+        exitwitherror("Unable to malloc the decompression buffer", 1);
+    }
+    for(;;) {
+        length = decompressread(reader->decompressor, buf, DECOMPRESSCHUNKSIZE);
+        pthread_mutex_lock(&reader->lock);
+        stopping = reader->stopping;
+        pthread_mutex_unlock(&reader->lock);
+        if(!length || stopping) {
+            break;
+        }
+        writeall(reader->pipefd, buf, length);
+    }
+    free(buf);
+    close(reader->pipefd);
+    return NULL;
+}
+#endif
+
+static void opendbfreader(DBFREADER *reader, const char *filename, const int usemmap) {
+    /* Open a .dbf file and prepare to read it. A file whose name ends in
+     * .zst or .gz is decompressed as it's read. */
+    FILE *file;
+    int   method = compressionmethod(filename);
+#if defined(HAVE_PTHREAD)
+    DECOMPRESSOR *decompressor;
+    int           fd;
+    int           pipefds[2];
+#endif
+
+    if(method == COMPRESSNONE) {
+        file = fopen(filename, "rb");
+        if(file == NULL) {
+            exitwitherror("Unable to open the DBF file", 1);
+        }
+        initdbfreader(reader, file, usemmap);
+        return;
+    }
+
+#if defined(HAVE_PTHREAD)
+    fd = open(filename, O_RDONLY);
+    if(fd == -1) {
+        exitwitherror("Unable to open the DBF file", 1);
+    }
+    decompressor = malloc(sizeof(DECOMPRESSOR));
+    if(decompressor == NULL) {
+        exitwitherror("Unable to malloc a decompressor", 1);
+    }
+    initdecompressor(decompressor, method, fd);
+    if(pipe(pipefds) == -1) {
+        exitwitherror("Unable to create a pipe for the decompressed DBF file", 1);
+    }
+#if defined(F_SETPIPE_SZ)
+    /* A bigger pipe lets the decompressor get further ahead. It's fine if
+     * the system won't allow it. */
+    fcntl(pipefds[1], F_SETPIPE_SZ, DBFBATCHTARGET);
+#endif
+    file = fdopen(pipefds[0], "rb");
+    if(file == NULL) {
+        exitwitherror("Unable to open the decompressed DBF file", 1);
+    }
+    initdbfreader(reader, file, 0);
+    reader->decompressor = decompressor;
+    reader->pipefd = pipefds[1];
+    if(pthread_mutex_init(&reader->lock, NULL) ||
+       pthread_create(&reader->thread, NULL, decompressdbfthread, reader)) {
+        exitwitherror("Unable to start the decompression thread", 0);
+    }
+#else
+    exitwitherror("Compressed DBF files can only be read if pgdbf was built with threads", 0);
+#endif
+}
+
+static int readdbfheader(DBFREADER *reader, void *buf, const size_t length) {
+    /* Read the next length bytes of the file's header into buf, or skip
+     * over them if buf is NULL. Returns 0 if they couldn't all be read. */
+    char   skipped[512];
+    size_t chunk;
+    size_t left;
+
+    if(buf != NULL) {
+        if(fread(buf, length, 1, reader->file) != 1) {
+            return 0;
+        }
+    } else {
+        /* Read instead of seeking so that this works on pipes */
+        for(left = length; left; left -= chunk) {
+            chunk = left < sizeof(skipped) ? left : sizeof(skipped);
+            if(fread(skipped, chunk, 1, reader->file) != 1) {
+                return 0;
+            }
+        }
+    }
+    reader->position += length;
+    return 1;
+}
+
+static void startdbfreader(DBFREADER *reader, const size_t headerlength, const size_t recordlength, const size_t firstrecord, const size_t recordcount, const size_t batchsize) {
+    /* Get ready to return recordcount records in batches, starting with
+     * record number firstrecord (counting from 0). Records are all the same
+     * length, so the reader goes straight to the first one without reading
+     * the ones before it. The file doesn't have to be positioned anywhere in
+     * particular. */
+    reader->offset = headerlength + firstrecord * recordlength;
+    reader->advised = reader->offset;
+    reader->recordlength = recordlength;
+    reader->recordsleft = recordcount;
+    reader->batchsize = batchsize;
+    if(reader->map != NULL) {
+#if defined(HAVE_MADVISE)
+        reader->pagesize = sysconf(_SC_PAGESIZE);
+        reader->released = reader->offset - reader->offset % reader->pagesize;
+        madvise(reader->map, reader->mapsize, MADV_SEQUENTIAL);
+#endif
+    } else {
+        if(reader->position != reader->offset) {
+            /* Pipes can't seek, but they can skip forward by reading */
+            if(fseek(reader->file, reader->offset, SEEK_SET) == 0) {
+                reader->position = reader->offset;
+            } else if(reader->offset < reader->position ||
+                      !readdbfheader(reader, NULL, reader->offset - reader->position)) {
+                exitwitherror("Unable to seek to the first record", 1);
+            }
+        }
+        /* The records may be read more than once */
+        free(reader->buffer);
+        reader->buffer = malloc(recordlength * batchsize);
+        if(reader->buffer == NULL) {
+            exitwitherror("Unable to malloc a record buffer", 1);
+        }
+    }
+}
+
+#if defined(HAVE_MADVISE)
+static void dbfreaderadvise(DBFREADER *reader, size_t start, size_t end, const int advice) {
+    /* Pass along advice about the mapped bytes from start to end. madvise()
+     * wants a page-aligned address, so start is rounded down. Failures are
+     * harmless and ignored. */
+    if(end > reader->mapsize) {
+        end = reader->mapsize;
+    }
+    start -= start % reader->pagesize;
+    if(end > start) {
+        madvise(reader->map + start, end - start, advice);
+    }
+}
+#endif
+
+static size_t readdbfbatch(DBFREADER *reader, const char **records) {
+    /* Point records at the next batch of records and return how many it
+     * holds, or 0 at the end of the table */
+    size_t count = reader->recordsleft < reader->batchsize ? reader->recordsleft : reader->batchsize;
+    size_t length = count * reader->recordlength;
+
+    if(!count) {
+        return 0;
+    }
+    if(reader->map != NULL) {
+        if(reader->offset + length > reader->mapsize) {
+            exitwitherror("Unable to read an entire record", 0);
+        }
+#if defined(HAVE_MADVISE)
+        /* Earlier batches have already been formatted, so their pages can
+         * be dropped. Then make sure the kernel is reading ahead of the
+         * batch that's about to be formatted. */
+        if(reader->offset - reader->offset % reader->pagesize > reader->released) {
+            dbfreaderadvise(reader, reader->released, reader->offset - reader->offset % reader->pagesize, MADV_DONTNEED);
+            reader->released = reader->offset - reader->offset % reader->pagesize;
+        }
+        if(reader->offset + length + DBFREADAHEAD > reader->advised) {
+            dbfreaderadvise(reader, reader->advised, reader->offset + length + DBFREADAHEAD, MADV_WILLNEED);
+            reader->advised = reader->offset + length + DBFREADAHEAD;
+        }
+#endif
+        *records = reader->map + reader->offset;
+    } else {
+        if(fread(reader->buffer, reader->recordlength, count, reader->file) != count) {
+            exitwitherror("Unable to read an entire record", ferror(reader->file));
+        }
+        reader->position += length;
+        *records = reader->buffer;
+    }
+    reader->offset += length;
+    reader->recordsleft -= count;
+    return count;
+}
+
+static void freedbfreader(DBFREADER *reader) {
+    /* Release the mapping or read buffer */
+    if(reader->map != NULL) {
+        if(munmap(reader->map, reader->mapsize) == -1) {
+            exitwitherror("Unable to munmap the DBF file", 1);
+        }
+    }
+    free(reader->buffer);
+    reader->buffer = NULL;
+}
+
+static void closedbfreader(DBFREADER *reader) {
+    /* Close the .dbf file, stopping its decompression thread if it has
+     * one */
+#if defined(HAVE_PTHREAD)
+    char buf[4096];
+
+    if(reader->decompressor != NULL) {
+        /* The thread may be waiting to write more than is needed. Tell it
+         * to stop, and read until it closes its end of the pipe. */
+        pthread_mutex_lock(&reader->lock);
+        reader->stopping = 1;
+        pthread_mutex_unlock(&reader->lock);
+        while(fread(buf, 1, sizeof(buf), reader->file)) {
+        }
+        if(pthread_join(reader->thread, NULL)) {
+            exitwitherror("Unable to join the decompression thread", 0);
+        }
+        pthread_mutex_destroy(&reader->lock);
+        close(reader->decompressor->fd);
+        freedecompressor(reader->decompressor);
+        free(reader->decompressor);
+    }
+#endif
+    fclose(reader->file);
+}
+
+/* Checkpoints */
+
+static size_t readcheckpoint(const char *filename, const char *tablename, const size_t recordlength, int *found, int *finished) {
+    /* Return the number of records that an earlier run of this table
+     * committed, according to its checkpoint file, and set finished if
+     * that run also built the indexes. found is set to 0 and 0 is returned
+     * if there's no checkpoint yet. */
+    FILE          *checkpointfile;
+    char           line[512];      /* Table names come from filenames, which
+                                    * are at most 255 bytes */
+    unsigned long  nextrecord;
+    unsigned long  checkpointlength;
+    int            tablenamestart;
+    size_t         linelength;
+
+    *found = 0;
+    *finished = 0;
+    checkpointfile = fopen(filename, "r");
+    if(checkpointfile == NULL) {
+        if(errno == ENOENT) {
+            return 0;
+        }
+        exitwitherror("Unable to open the checkpoint file", 1);
+    }
+    if(fgets(line, sizeof(line), checkpointfile) == NULL ||
+       sscanf(line, "%lu %lu %d %n", &nextrecord, &checkpointlength, finished, &tablenamestart) != 3) {
+        exitwitherror("The checkpoint file is corrupt", 0);
+    }
+    fclose(checkpointfile);
+    linelength = strlen(line);
+    if(linelength && line[linelength - 1] == '\n') {
+        line[linelength - 1] = '\0';
+    }
+    if(strcmp(line + tablenamestart, tablename) || checkpointlength != recordlength) {
+        exitwitherror("The checkpoint file was written for a different table", 0);
+    }
+    *found = 1;
+    return nextrecord;
+}
+
+static void writecheckpoint(const char *filename, const char *tablename, const size_t recordlength, const size_t nextrecord,
+                            const int finished) {
+    /* Record that everything before nextrecord has been committed, and
+     * whether the load is finished with the indexes built too. The
+     * checkpoint is written to a temporary file which then replaces the
+     * old one, so a crash leaves either the old checkpoint or the new one
+     * but never a partial file. */
+    FILE *checkpointfile;
+    char *tempfilename;
+
+    if(asprintf(&tempfilename, "%s.tmp", filename) < 0) {
+        exitwitherror("Unable to allocate the checkpoint filename", 1);
+    }
+    checkpointfile = fopen(tempfilename, "w");
+    if(checkpointfile == NULL) {
+        exitwitherror("Unable to create the checkpoint file", 1);
+    }
+    fprintf(checkpointfile, "%lu %lu %d %s\n", (unsigned long) nextrecord, (unsigned long) recordlength, finished, tablename);
+    if(fflush(checkpointfile) || fsync(fileno(checkpointfile)) || fclose(checkpointfile)) {
+        exitwitherror("Unable to write the checkpoint file", 1);
+    }
+    if(rename(tempfilename, filename)) {
+        exitwitherror("Unable to replace the checkpoint file", 1);
+    }
+    free(tempfilename);
+}
+
+static void writeserverprogress(OUTBUF *output, const char *tablename, const size_t nextrecord, const int finished) {
+    /* Append the statement that records a checkpointed load's progress on
+     * the server. It runs in the same transaction as the records it counts,
+     * so the two are committed together or not at all. */
+    outbufprintf(output, "INSERT INTO %s VALUES (", CHECKPOINTTABLE);
+    outbufquoted(output, tablename);
+    outbufprintf(output, ", %lu, %s) ON CONFLICT (tablename) DO UPDATE "
+                 "SET nextrecord = EXCLUDED.nextrecord, finished = EXCLUDED.finished;\n",
+                 (unsigned long) nextrecord, finished ? "TRUE" : "FALSE");
+}
+
+/* Fingerprints */
+
+static uint64_t hashround(uint64_t lane, const uint64_t word) {
+    /* Mix one 8-byte word into a hash lane */
+    lane += word * HASHPRIME2;
+    lane = (lane << 31) | (lane >> 33);
+    return lane * HASHPRIME1;
+}
+
+static uint64_t hashbytes(const char *data, const size_t length, uint64_t hash) {
+    /* A fast 64-bit hash in the style of xxHash, for noticing records that
+     * have changed. It isn't meant to stand up to deliberate collisions.
+     * Four lanes take turns with each 32 bytes, so their multiplies run in
+     * parallel and hashing keeps up with memory. */
+    const char *end = data + length;
+    uint64_t    lanes[4];
+    uint64_t    word;
+    int         i;
+
+    if(length >= 32) {
+        lanes[0] = hash + HASHPRIME1 + HASHPRIME2;
+        lanes[1] = hash + HASHPRIME2;
+        lanes[2] = hash;
+        lanes[3] = hash - HASHPRIME1;
+        do {
+            for(i = 0; i < 4; i++) {
+                memcpy(&word, data + i * 8, 8);
+                lanes[i] = hashround(lanes[i], word);
+            }
+            data += 32;
+        } while(end - data >= 32);
+        hash = ((lanes[0] << 1) | (lanes[0] >> 63)) + ((lanes[1] << 7) | (lanes[1] >> 57)) +
+               ((lanes[2] << 12) | (lanes[2] >> 52)) + ((lanes[3] << 18) | (lanes[3] >> 46));
+    } else {
+        hash += HASHPRIME3;
+    }
+    hash += length;
+    while(end - data >= 8) {
+        memcpy(&word, data, 8);
+        hash ^= hashround(0, word);
+        hash = ((hash << 27) | (hash >> 37)) * HASHPRIME1 + HASHPRIME3;
+        data += 8;
+    }
+    while(data < end) {
+        hash ^= (uint8_t) *data++ * HASHPRIME3;
+        hash = ((hash << 11) | (hash >> 53)) * HASHPRIME1;
+    }
+    hash ^= hash >> 33;
+    hash *= HASHPRIME2;
+    hash ^= hash >> 29;
+    hash *= HASHPRIME3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+static uint64_t hashrecord(const TABLEINFO *table, const char *record) {
+    /* Fingerprint a record along with the memos it refers to. Deleted
+     * records get 0, and nothing else does. */
+    const FIELDSTEP *step;
+    const char      *memo;
+    size_t           memolength;
+    uint64_t         hash;
+
+    if(record[0] == '*') {
+        return 0;
+    }
+    hash = hashbytes(record, table->recordlength, 0);
+    for(step = table->plan; step < table->plan + table->plansize; step++) {
+        if(ismemotype(step->type)) {
+            memo = memovalue(table, step->pgfield, record + step->offset, &memolength);
+            if(memo != NULL) {
+                hash = hashbytes(memo, memolength, hash);
+            }
+        }
+    }
+    return hash ? hash : 1;
+}
+
+static void initfingerprints(FINGERPRINTS *fingerprints, FILE *oldfile, const char *newfilename, const TABLEINFO *table,
+                             const FIELDSTEP *keyplan, const size_t keycount, const size_t longestfield, const char *inputcharset) {
+    /* Start writing newfilename, and check that the fingerprints in
+     * oldfile, if there is one, were made with the same table layout and
+     * key columns. keyplan formats the key columns. */
+    FINGERPRINTHEADER header;
+    FINGERPRINTHEADER oldheader;
+    size_t            i;
+
+    memset(fingerprints, 0, sizeof(FINGERPRINTS));
+    fingerprints->table = table;
+    fingerprints->keytable = *table;
+    fingerprints->keytable.plan = keyplan;
+    fingerprints->keytable.plansize = keycount;
+    fingerprints->keytable.binary = 0;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, FINGERPRINTMAGIC, sizeof(header.magic));
+    header.byteorder = FINGERPRINTBYTEORDER;
+    header.recordlength = table->recordlength;
+    for(i = 0; i < keycount; i++) {
+        header.keylength += keyplan[i].length;
+        header.layout = hashbytes((const char *) &keyplan[i].offset, sizeof(keyplan[i].offset), header.layout);
+        header.layout = hashbytes(&keyplan[i].type, 1, header.layout);
+    }
+    fingerprints->keylength = header.keylength;
+    fingerprints->entrylength = sizeof(uint64_t) + header.keylength;
+
+    fingerprints->oldfile = oldfile;
+    fingerprints->delta = oldfile != NULL;
+    if(oldfile != NULL) {
+        if(fread(&oldheader, sizeof(oldheader), 1, oldfile) != 1 ||
+           memcmp(oldheader.magic, FINGERPRINTMAGIC, sizeof(oldheader.magic))) {
+            exitwitherror("The fingerprint file is corrupt", 0);
+        }
+        if(oldheader.byteorder != FINGERPRINTBYTEORDER) {
+            exitwitherror("The fingerprint file was written on a machine with a different byte order", 0);
+        }
+        if(oldheader.recordlength != header.recordlength || oldheader.keylength != header.keylength ||
+           oldheader.layout != header.layout) {
+            exitwitherror("The fingerprint file was written for a different table or key", 0);
+        }
+    }
+    fingerprints->newfile = fopen(newfilename, "wb");
+    if(fingerprints->newfile == NULL) {
+        exitwitherror("Unable to create the new fingerprint file", 1);
+    }
+    if(fwrite(&header, sizeof(header), 1, fingerprints->newfile) != 1) {
+        exitwitherror("Unable to write the new fingerprint file", 1);
+    }
+
+    fingerprints->oldentry = malloc(fingerprints->entrylength);
+    fingerprints->newentry = malloc(fingerprints->entrylength);
+    fingerprints->keyrecord = calloc(1, table->recordlength);
+    if(fingerprints->oldentry == NULL || fingerprints->newentry == NULL || fingerprints->keyrecord == NULL) {
+        exitwitherror("Unable to malloc the fingerprint buffers", 1);
+    }
+    fingerprints->keyrecord[0] = ' ';
+    initformatter(&fingerprints->keyformatter, NULL, longestfield, 0, inputcharset, 0, NULL);
+}
+
+static uint64_t readoldfingerprint(FINGERPRINTS *fingerprints) {
+    /* Read the next entry from the old fingerprints and return its hash,
+     * or 0 if there are no more */
+    uint64_t hash;
+
+    if(fingerprints->oldfile == NULL) {
+        return 0;
+    }
+    if(fread(fingerprints->oldentry, fingerprints->entrylength, 1, fingerprints->oldfile) != 1) {
+        if(ferror(fingerprints->oldfile)) {
+            exitwitherror("Unable to read the fingerprint file", 1);
+        }
+        fclose(fingerprints->oldfile);
+        fingerprints->oldfile = NULL;
+        return 0;
+    }
+    memcpy(&hash, fingerprints->oldentry, sizeof(hash));
+    return hash;
+}
+
+static void forgetoldkey(FINGERPRINTS *fingerprints) {
+    /* Add the key from the old entry to the rows that will be deleted. It's
+     * formatted by copying the key's bytes back into a blank record. */
+    const FIELDSTEP *step;
+    const char      *key = fingerprints->oldentry + sizeof(uint64_t);
+    const OUTBUF    *keys = fingerprints->keyformatter.output;
+    size_t           start = keys->length;
+    size_t           i;
+
+    for(step = fingerprints->keytable.plan; step < fingerprints->keytable.plan + fingerprints->keytable.plansize; step++) {
+        memcpy(fingerprints->keyrecord + step->offset, key, step->length);
+        key += step->length;
+    }
+    formatrecords(&fingerprints->keyformatter, &fingerprints->keytable, fingerprints->keyrecord, 1);
+
+    /* A NULL column is written as a bare \N, and escaped backslashes
+     * always come in pairs, so any field that's exactly \N is one */
+    for(i = start; i + 2 < keys->length; i++) {
+        if((i == start || keys->data[i - 1] == '\t') && keys->data[i] == '\\' && keys->data[i + 1] == 'N' &&
+           (keys->data[i + 2] == '\t' || keys->data[i + 2] == '\n')) {
+            fingerprints->nullkeys = 1;
+        }
+    }
+}
+
+static void fingerprintbatch(FINGERPRINTS *fingerprints, FORMATTER *formatter, const char *records, const size_t recordcount) {
+    /* Record the fingerprint of each record in a batch. For a delta, also
+     * write the records that are new or have changed to the formatter, and
+     * remember the old keys of the ones that changed or were deleted. */
+    const FIELDSTEP *step;
+    const char      *record;
+    char            *key;
+    size_t           recordnum;
+    uint64_t         newhash;
+    uint64_t         oldhash;
+
+    for(recordnum = 0; recordnum < recordcount; recordnum++) {
+        record = records + fingerprints->table->recordlength * recordnum;
+        newhash = hashrecord(fingerprints->table, record);
+        memcpy(fingerprints->newentry, &newhash, sizeof(newhash));
+        key = fingerprints->newentry + sizeof(newhash);
+        for(step = fingerprints->keytable.plan; step < fingerprints->keytable.plan + fingerprints->keytable.plansize; step++) {
+            memcpy(key, record + step->offset, step->length);
+            key += step->length;
+        }
+        if(fwrite(fingerprints->newentry, fingerprints->entrylength, 1, fingerprints->newfile) != 1) {
+            exitwitherror("Unable to write the new fingerprint file", 1);
+        }
+        if(!fingerprints->delta) {
+            continue;
+        }
+
+        oldhash = readoldfingerprint(fingerprints);
+        if(newhash == oldhash) {
+            continue;
+        }
+        if(oldhash) {
+            forgetoldkey(fingerprints);
+            if(newhash) {
+                fingerprints->changed++;
+            } else {
+                fingerprints->removed++;
+            }
+        } else {
+            fingerprints->added++;
+        }
+        if(newhash) {
+            formatrecords(formatter, fingerprints->table, record, 1);
+        }
+    }
+}
+
+static void finishfingerprints(FINGERPRINTS *fingerprints) {
+    /* Treat old records past the end of the table as deleted, and finish
+     * the new fingerprint file. The keys of the rows to delete are left in
+     * keyformatter's output. */
+    while(fingerprints->oldfile != NULL) {
+        if(readoldfingerprint(fingerprints)) {
+            forgetoldkey(fingerprints);
+            fingerprints->removed++;
+        }
+    }
+    if(fclose(fingerprints->newfile)) {
+        exitwitherror("Unable to write the new fingerprint file", 1);
+    }
+    free(fingerprints->oldentry);
+    free(fingerprints->newentry);
+    free(fingerprints->keyrecord);
+}
+
+/* Batch mode */
+
+static char *maketablename(const char *dbffilename) {
+    /* Return the table name for a DBF file: its filename, without any
+     * directories or extension, in lowercase */
+    const char *s;
+    char       *tablename;
+    char       *t;
+
+    tablename = malloc(strlen(dbffilename) + 1);
+    if(tablename == NULL) {
+        exitwitherror("Unable to allocate the tablename buffer", 1);
+    }
+    s = dbffilename + strlen(dbffilename);
+    while(s > dbffilename && s[-1] != '/') {
+        s--;
+    }
+    for(t = tablename; *s && *s != '.'; s++) {
+        *t++ = tolower(*s);
+    }
+    *t = '\0';
+    return tablename;
+}
+
+static char *findmemofile(const char *dbffilename) {
+    /* Return the name of the memo file that goes with a DBF file, or NULL
+     * if there isn't one. FoxPro calls them "name.fpt" and dBASE calls them
+     * "name.dbt". Either the DBF file or the memo file may be compressed,
+     * like "name.dbf.zst" and "name.fpt.gz". */
+    static const char *MEMOEXTENSIONS[] = {".fpt", ".FPT", ".dbt", ".DBT", NULL};
+    const char *basename;
+    const char *extension;
+    char       *memofilename;
+    size_t      baselength;
+    int         i;
+    int         j;
+
+    basename = strrchr(dbffilename, '/');
+    basename = basename == NULL ? dbffilename : basename + 1;
+    baselength = strlen(dbffilename) - strlen(COMPRESSSUFFIXES[compressionmethod(dbffilename)]);
+    extension = dbffilename + baselength;
+    while(extension > basename && extension[-1] != '.') {
+        extension--;
+    }
+    if(extension > basename) {
+        baselength = extension - 1 - dbffilename;
+    }
+
+    memofilename = malloc(baselength + 9);
+    if(memofilename == NULL) {
+        exitwitherror("Unable to allocate the memo filename buffer", 1);
+    }
+    for(i = 0; MEMOEXTENSIONS[i] != NULL; i++) {
+        for(j = COMPRESSNONE; j <= COMPRESSGZIP; j++) {
+            memcpy(memofilename, dbffilename, baselength);
+            sprintf(memofilename + baselength, "%s%s", MEMOEXTENSIONS[i], COMPRESSSUFFIXES[j]);
+            if(!access(memofilename, R_OK)) {
+                return memofilename;
+            }
+        }
+    }
+    free(memofilename);
+    return NULL;
+}
+
+static void addbatchtable(BATCH *batch, const char *dbffilename) {
+    /* Add a DBF file, and its memo file if it has one, to the batch */
+    BATCHTABLE  *table;
+    struct stat  filestat;
+
+    if(batch->tablecount == batch->size) {
+        batch->size = batch->size ? batch->size * 2 : 64;
+        batch->tables = realloc(batch->tables, batch->size * sizeof(BATCHTABLE));
+        if(batch->tables == NULL) {
+            exitwitherror("Unable to realloc the batch table list", 1);
+        }
+    }
+    table = &batch->tables[batch->tablecount++];
+
+    if(stat(dbffilename, &filestat) == -1) {
+        fprintf(stderr, "Unable to stat %s: %s\n", dbffilename, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    table->dbffilename = strdup(dbffilename);
+    if(table->dbffilename == NULL) {
+        exitwitherror("Unable to allocate a batch filename", 1);
+    }
+    table->size = filestat.st_size;
+    table->memofilename = findmemofile(dbffilename);
+    if(table->memofilename != NULL && stat(table->memofilename, &filestat) == 0) {
+        table->size += filestat.st_size;
+    }
+    table->tablename = maketablename(dbffilename);
+}
+
+static void addbatchpath(BATCH *batch, const char *path) {
+    /* Add a DBF file to the batch, or every DBF file in a directory,
+     * including compressed ones */
+    DIR           *dir;
+    struct dirent *entry;
+    struct stat    pathstat;
+    char          *filename;
+    size_t         length;
+
+    if(stat(path, &pathstat) == -1) {
+        fprintf(stderr, "Unable to stat %s: %s\n", path, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    if(!S_ISDIR(pathstat.st_mode)) {
+        addbatchtable(batch, path);
+        return;
+    }
+
+    dir = opendir(path);
+    if(dir == NULL) {
+        fprintf(stderr, "Unable to open %s: %s\n", path, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    while((entry = readdir(dir)) != NULL) {
+        length = strlen(entry->d_name) - strlen(COMPRESSSUFFIXES[compressionmethod(entry->d_name)]);
+        if(length < 5 || strncasecmp(entry->d_name + length - 4, ".dbf", 4)) {
+            continue;
+        }
+        if(asprintf(&filename, "%s/%s", path, entry->d_name) < 0) {
+            exitwitherror("Unable to allocate a batch filename", 1);
+        }
+        addbatchtable(batch, filename);
+        free(filename);
+    }
+    closedir(dir);
+}
+
+static int comparebatchtables(const void *a, const void *b) {
+    /* qsort() comparison function that puts the largest tables first. Ties
+     * are broken by name to keep the order predictable. */
+    const BATCHTABLE *x = (const BATCHTABLE *) a;
+    const BATCHTABLE *y = (const BATCHTABLE *) b;
+
+    if(x->size != y->size) {
+        return x->size > y->size ? -1 : 1;
+    }
+    return strcmp(x->tablename, y->tablename);
+}
+
+static void initbatch(BATCH *batch, char **paths, const int pathcount) {
+    /* Find all of the tables to convert and put the largest ones first so
+     * that the longest conversions aren't left until the end */
+    size_t i;
+    size_t j;
+
+    memset(batch, 0, sizeof(BATCH));
+    for(i = 0; i < (size_t) pathcount; i++) {
+        addbatchpath(batch, paths[i]);
+    }
+    if(!batch->tablecount) {
+        exitwitherror("No DBF files were found", 0);
+    }
+    qsort(batch->tables, batch->tablecount, sizeof(BATCHTABLE), comparebatchtables);
+
+    /* Each table is written to its own file, or loaded into its own table,
+     * so two DBF files with the same name can't be converted together */
+    for(i = 0; i < batch->tablecount; i++) {
+        for(j = i + 1; j < batch->tablecount; j++) {
+            if(!strcmp(batch->tables[i].tablename, batch->tables[j].tablename)) {
+                fprintf(stderr, "%s and %s would both be converted to table %s\n",
+                        batch->tables[i].dbffilename, batch->tables[j].dbffilename, batch->tables[i].tablename);
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+#if defined(HAVE_PTHREAD)
+    if(pthread_mutex_init(&batch->lock, NULL)) {
+        exitwitherror("Unable to initialize the batch lock", 0);
+    }
+#endif
+}
+
+static BATCHTABLE *nextbatchtable(BATCH *batch) {
+    /* Hand out the next table to convert, or NULL if they're all taken */
+    BATCHTABLE *table = NULL;
+
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_lock(&batch->lock);
+#endif
+    if(batch->next < batch->tablecount) {
+        table = &batch->tables[batch->next++];
+    }
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_unlock(&batch->lock);
+#endif
+    return table;
+}
+
+static void freebatch(BATCH *batch) {
+    /* Release everything that initbatch() acquired */
+    size_t i;
+
+    for(i = 0; i < batch->tablecount; i++) {
+        free(batch->tables[i].dbffilename);
+        free(batch->tables[i].memofilename);
+        free(batch->tables[i].tablename);
+    }
+    free(batch->tables);
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_destroy(&batch->lock);
+#endif
+}
+
+#if defined(HAVE_LIBPQ)
+/* Loading directly into PostgreSQL. The SQL statements that would otherwise
+ * be printed are collected in an output buffer and sent with PQexec(), and
+ * the COPY data is streamed with PQputCopyData() as the buffer fills. */
+
+static PGconn *connecttodatabase(const char *conninfo) {
+    /* Open a connection to the server, or exit with an explanation */
+    PGconn *conn = PQconnectdb(conninfo);
+
+    if(PQstatus(conn) != CONNECTION_OK) {
+        fprintf(stderr, "Unable to connect to the database: %s", PQerrorMessage(conn));
+        exit(EXIT_FAILURE);
+    }
+    return conn;
+}
+
+static void checkresult(PGconn *conn, PGresult *result, const ExecStatusType expected, const char *message) {
+    /* Exit with the server's error message if a command failed. Closing the
+     * connection rolls back any open transaction. */
+    if(PQresultStatus(result) != expected) {
+        fprintf(stderr, "%s: %s", message, PQerrorMessage(conn));
+        PQclear(result);
+        PQfinish(conn);
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void runstatements(PGconn *conn, OUTBUF *statements) {
+    /* Execute the SQL collected in the buffer, then empty it */
+    PGresult *result;
+
+    if(!statements->length) {
+        return;
+    }
+    outbufputc(statements, '\0');
+    result = PQexec(conn, statements->data);
+    checkresult(conn, result, PGRES_COMMAND_OK, "Unable to run the SQL statements");
+    PQclear(result);
+    statements->length = 0;
+}
+
+static void copysink(OUTBUF *outbuf, const char *buf, const size_t length) {
+    /* Send a chunk of COPY data to the server */
+    PGconn *conn = (PGconn *) outbuf->sinkarg;
+
+    if(PQputCopyData(conn, buf, length) != 1) {
+        fprintf(stderr, "Unable to send the COPY data: %s", PQerrorMessage(conn));
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void startcopy(PGconn *conn, const char *command, OUTBUF *copyoutput) {
+    /* Put the server into COPY mode and point the output buffer at it */
+    PGresult *result;
+
+    result = PQexec(conn, command);
+    checkresult(conn, result, PGRES_COPY_IN, "Unable to start the COPY");
+    PQclear(result);
+    copyoutput->sink = copysink;
+    copyoutput->sinkarg = conn;
+}
+
+static void finishcopy(PGconn *conn, OUTBUF *copyoutput, const char *tablename) {
+    /* Send the rest of the COPY data and report how many rows the server
+     * says it received */
+    PGresult *result;
+
+    outbufflush(copyoutput);
+    if(PQputCopyEnd(conn, NULL) != 1) {
+        fprintf(stderr, "Unable to finish the COPY: %s", PQerrorMessage(conn));
+        exit(EXIT_FAILURE);
+    }
+    result = PQgetResult(conn);
+    checkresult(conn, result, PGRES_COMMAND_OK, "The COPY failed");
+    fprintf(stderr, "Copied %s rows into %s\n", PQcmdTuples(result), tablename);
+    PQclear(result);
+    while((result = PQgetResult(conn)) != NULL) {
+        PQclear(result);
+    }
+}
+
+static size_t readserverprogress(PGconn *conn, const char *tablename, int *found, int *finished) {
+    /* Return the number of records that the server has committed for a
+     * checkpointed load of this table, and set finished if the indexes were
+     * built too. found is set to 0 if the server has no record of it. */
+    const char *params[1];
+    PGresult   *result;
+    size_t      nextrecord = 0;
+
+    *found = 0;
+    *finished = 0;
+    result = PQexec(conn, "SELECT to_regclass('" CHECKPOINTTABLE "') IS NOT NULL");
+    checkresult(conn, result, PGRES_TUPLES_OK, "Unable to look for the checkpoint table");
+    if(strcmp(PQgetvalue(result, 0, 0), "t")) {
+        PQclear(result);
+        return 0;
+    }
+    PQclear(result);
+    params[0] = tablename;
+    result = PQexecParams(conn, "SELECT nextrecord, finished FROM " CHECKPOINTTABLE " WHERE tablename = $1",
+                          1, NULL, params, NULL, NULL, 0);
+    checkresult(conn, result, PGRES_TUPLES_OK, "Unable to read the checkpoint table");
+    if(PQntuples(result)) {
+        *found = 1;
+        nextrecord = strtoul(PQgetvalue(result, 0, 0), NULL, 10);
+        *finished = !strcmp(PQgetvalue(result, 0, 1), "t");
+    }
+    PQclear(result);
+    return nextrecord;
+}
 #endif